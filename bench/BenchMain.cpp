@@ -0,0 +1,59 @@
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <string>
+
+#include "Benchmark.h"
+
+// Counting replacements of the global allocation functions; the array and nothrow forms call these
+static atomic<size_t> allocations{0};
+
+void *operator new(const size_t size) {
+    allocations.fetch_add(1, memory_order_relaxed);
+    if (void *memory = malloc(size == 0 ? 1 : size)) {
+        return memory;
+    }
+    throw bad_alloc();
+}
+
+void operator delete(void *memory) noexcept {
+    free(memory);
+}
+
+void operator delete(void *memory, size_t) noexcept {
+    free(memory);
+}
+
+size_t allocationCount() {
+    return allocations.load(memory_order_relaxed);
+}
+
+struct Suite {
+    const char *name;
+
+    void (*run)();
+};
+
+static constexpr Suite suites[] = {
+    {"value", runValueBenchmarks},
+    {"lexer", runLexerBenchmarks},
+    {"parser", runParserBenchmarks},
+    {"interpreter", runInterpreterBenchmarks},
+};
+
+// Usage: YoloBench [suite...]; with no arguments every suite runs
+int main(int argc, char *argv[]) {
+    for (const Suite &suite: suites) {
+        bool selected = argc == 1;
+        for (int i = 1; i < argc; i++) {
+            selected = selected || strcmp(argv[i], suite.name) == 0;
+        }
+        if (selected) {
+            cout << "[" << suite.name << "]" << endl;
+            suite.run();
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,60 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <chrono>
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+// Keeps the optimizer from discarding a benchmark result
+template<typename T>
+inline void doNotOptimize(const T &value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// Runs body `iterations` times and returns the average nanoseconds per iteration
+template<typename Body>
+double timeIterations(const size_t iterations, Body &&body) {
+    const auto start = chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; i++) {
+        body();
+    }
+    const auto elapsed = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+    return elapsed / static_cast<double>(iterations);
+}
+
+// Runs body `iterations` times and prints the average cost of one iteration
+template<typename Body>
+double runBenchmark(const string &name, const size_t iterations, Body &&body) {
+    const double perIteration = timeIterations(iterations, body);
+    cout << "  " << left << setw(48) << name << right << setw(12) << fixed << setprecision(2) << perIteration
+            << " ns/iter" << endl;
+    return perIteration;
+}
+
+// Runs body, which processes `bytes` bytes of input, `iterations` times and prints the throughput
+template<typename Body>
+double runThroughputBenchmark(const string &name, const size_t iterations, const size_t bytes, Body &&body) {
+    const double perIteration = timeIterations(iterations, body);
+    const double megabytesPerSecond = static_cast<double>(bytes) / perIteration * 1e9 / (1024 * 1024);
+    cout << "  " << left << setw(48) << name << right << setw(12) << fixed << setprecision(2) << megabytesPerSecond
+            << " MB/s" << endl;
+    return megabytesPerSecond;
+}
+
+// Calls to the global operator new so far. BenchMain.cpp replaces the allocation functions to count them.
+size_t allocationCount();
+
+// Benchmark suites, one per file in bench/
+void runValueBenchmarks();
+
+void runLexerBenchmarks();
+
+void runParserBenchmarks();
+
+void runInterpreterBenchmarks();
+
+#endif // BENCHMARK_H
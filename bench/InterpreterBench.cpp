@@ -0,0 +1,109 @@
+#include <string>
+#include <string_view>
+
+#include "Benchmark.h"
+#include "ast/CompilationUnit.h"
+#include "ast/FlatAST.h"
+#include "compiler/Compiler.h"
+#include "interpreter/Interpreter.h"
+#include "lexer/Lexer.h"
+#include "lexer/TokenStream.h"
+#include "parser/Parser.h"
+#include "resolver/Resolver.h"
+#include "vm/VM.h"
+
+// Evaluation and dispatch cost per loop iteration of small scripts, on every engine: the visitor-
+// based tree walk, the walk over the flattened AST, and the bytecode VM with switch and with threaded
+// dispatch. All of them return expression values directly, so the tree and flat walks differ in
+// visitor dispatch and the nodes' accept tracing, and the two VM rows only in how they dispatch.
+// Each row also counts the heap allocations per iteration.
+
+namespace {
+    constexpr size_t loopCount = 2000;
+
+    // Every script is a while loop of `loopCount` iterations over `body`, with i as the counter
+    string loop(const string_view setup, const string_view body) {
+        return string(setup) + " let i = 0; while (i < " + to_string(loopCount) + ") { " + string(body) +
+               " i = i + 1; }";
+    }
+
+    // Arithmetic on locals: nothing but binary expressions, identifiers and assignments
+    const string arithmetic = loop("let sum = 0;", "sum = sum + i * 2 - i % 7 / 3;");
+
+    // Short-circuiting conditions and bitwise operators
+    const string branching = loop("let acc = 0; let flag = 0;",
+                                  "if (i & 1 && i > 3 || !flag) { acc = acc ^ i << 2; } flag = !flag;");
+
+    // Property accesses and calls into a builtin
+    const string calls = loop("let items = Array.create();", "items.push(items, i);");
+
+    // String values read from variables, copied into other variables and stored into an array. The
+    // string is too long for the small-string buffer, so a deep copy would allocate.
+    const string strings = loop(
+        "let text = \"the quick brown fox jumps over the lazy dog\"; let words = Array.create();",
+        "let copy = text; let again = copy; words.push(words, again);");
+
+    // Short-lived objects: a block scope and an array per iteration, nearly all of them garbage
+    // by the next one
+    const string allocation = loop("let kept = Array.create();",
+                                   "{ let fresh = Array.create(); fresh.push(fresh, i); if (i % 100 == 0) { kept = fresh; } }");
+
+    struct Measurement {
+        double nanoseconds;
+        size_t allocations;
+    };
+
+    template<typename Body>
+    Measurement measure(const size_t iterations, Body &&body) {
+        const size_t before = allocationCount();
+        const double nanoseconds = timeIterations(iterations, body);
+        return {nanoseconds, (allocationCount() - before) / iterations};
+    }
+
+    void report(const string &engine, const Measurement &measurement) {
+        cout << "  " << left << setw(48) << "    " + engine << right << setw(12) << fixed << setprecision(2)
+                << measurement.nanoseconds / loopCount << " ns/loop" << setw(10) << setprecision(1)
+                << static_cast<double>(measurement.allocations) / loopCount << " allocs/loop" << endl;
+    }
+
+    void runScript(const string &name, const string &script) {
+        // The AST passes and every engine trace or print as they go; keep that out of the measurement
+        cout << "  " << name << endl;
+        cout.setstate(ios::badbit);
+        Lexer lexer(script);
+        TokenStream tokens(lexer);
+        CompilationUnit unit;
+        Parser(tokens).parseInto(unit);
+        const Chunk chunk = Compiler().compile(unit.statements);
+        Resolver().resolve(unit.statements);
+        FlatProgram program = Flattener().flatten(unit.statements);
+
+        constexpr size_t iterations = 20;
+        const Measurement tree = measure(iterations, [&] {
+            Interpreter().interpret(unit.statements);
+        });
+        const Measurement flat = measure(iterations, [&] {
+            Interpreter().interpret(program);
+        });
+        const Measurement switched = measure(iterations, [&] {
+            VM(VM::Dispatch::SWITCH).run(chunk);
+        });
+        const Measurement threaded = measure(iterations, [&] {
+            VM(VM::Dispatch::THREADED).run(chunk);
+        });
+        cout.clear();
+        report("tree walk", tree);
+        report("flat walk", flat);
+        report("VM, switch dispatch", switched);
+        report("VM, threaded dispatch", threaded);
+    }
+}
+
+void runInterpreterBenchmarks() {
+    cout << " every engine over " << loopCount << "-iteration loops" << endl;
+    runScript("arithmetic loop", arithmetic);
+    runScript("branching loop", branching);
+    runScript("call loop", calls);
+    runScript("string loop", strings);
+    runScript("allocation loop", allocation);
+}
@@ -0,0 +1,185 @@
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "Benchmark.h"
+#include "lexer/Keywords.h"
+#include "lexer/Lexer.h"
+#include "lexer/Scan.h"
+
+// Lexing throughput over synthetic scripts of about 1 MB, each dominated by one kind of run the
+// scanners in src/lexer/Scan.h handle: long identifiers, indentation and comments, string bodies.
+
+namespace {
+    constexpr size_t targetSize = 1 << 20;
+
+    string repeatToSize(const string_view pattern) {
+        string text;
+        text.reserve(targetSize + pattern.size());
+        while (text.size() < targetSize) {
+            text += pattern;
+        }
+        return text;
+    }
+
+    const string identifierHeavy = repeatToSize(
+        "let configuration_value_alpha = previous_configuration_value + default_offset_for_alpha;\n");
+
+    const string commentHeavy = repeatToSize(
+        "        // Generated setting; the value below is copied from the upstream template verbatim\n"
+        "        /* Block comments are also common in generated output,\n"
+        "           and often span several indented lines */\n"
+        "        x = 1;\n");
+
+    const string stringHeavy = repeatToSize(
+        "label = \"a generated label that is reasonably long and has an \\\"escaped\\\" quote in it\";\n");
+
+    // Walks the whole text, calling `scan` at the start of every run of `runClass` bytes
+    template<typename Scan>
+    size_t walkRuns(const string_view text, const uint8_t runClass, Scan scan) {
+        size_t runs = 0;
+        for (size_t i = 0; i < text.size();) {
+            if (hasClass(text[i], runClass)) {
+                i = scan(text, i);
+                runs++;
+            } else {
+                i++;
+            }
+        }
+        return runs;
+    }
+
+    // Walks the whole text with `scan`, stepping over the byte that ends each run
+    template<typename Scan>
+    size_t walkUntil(const string_view text, Scan scan) {
+        size_t runs = 0;
+        for (size_t i = 0; i < text.size(); i = scan(text, i) + 1) {
+            runs++;
+        }
+        return runs;
+    }
+
+    // Every identifier-like word of the identifier-heavy script, in order
+    vector<string_view> wordsOf(const string_view text) {
+        vector<string_view> words;
+        for (size_t i = 0; i < text.size();) {
+            if (hasClass(text[i], IDENTIFIER_START)) {
+                const size_t end = scanIdentifier(text, i);
+                words.push_back(text.substr(i, end - i));
+                i = end;
+            } else {
+                i++;
+            }
+        }
+        return words;
+    }
+
+    // The previous classification: copy the word into a string, probe a hash map, then compare
+    // against the declaration keywords that were not in the map
+    TokenType legacyClassify(const string_view word) {
+        static const unordered_map<string, TokenType> keywordMap = [] {
+            unordered_map<string, TokenType> map;
+            for (const Keyword &keyword: keywords) {
+                if (keyword.type != TokenType::LET && keyword.type != TokenType::CONST &&
+                    keyword.type != TokenType::VAR) {
+                    map.emplace(keyword.text, keyword.type);
+                }
+            }
+            return map;
+        }();
+        const string lexeme(word);
+        TokenType type = TokenType::IDENTIFIER;
+        const auto it = keywordMap.find(lexeme);
+        if (it != keywordMap.end()) {
+            type = it->second;
+        }
+        if (lexeme == "let") {
+            return TokenType::LET;
+        } else if (lexeme == "const") {
+            return TokenType::CONST;
+        } else if (lexeme == "var") {
+            return TokenType::VAR;
+        }
+        return type;
+    }
+
+    size_t lexAll(const string_view text) {
+        Lexer lexer(text);
+        size_t count = 0;
+        while (lexer.nextToken().type != TokenType::EOF_TOKEN) {
+            count++;
+        }
+        return count;
+    }
+}
+
+void runLexerBenchmarks() {
+    constexpr size_t iterations = 50;
+
+    cout << " run scanners, SIMD block scan vs byte at a time" << endl;
+    runThroughputBenchmark("identifier bodies (scalar)", iterations, identifierHeavy.size(), [] {
+        doNotOptimize(walkRuns(identifierHeavy, IDENTIFIER_PART, [](string_view text, size_t i) {
+            return scanIdentifierScalar(text, i);
+        }));
+    });
+    runThroughputBenchmark("identifier bodies (block)", iterations, identifierHeavy.size(), [] {
+        doNotOptimize(walkRuns(identifierHeavy, IDENTIFIER_PART, [](string_view text, size_t i) {
+            return scanIdentifier(text, i);
+        }));
+    });
+    runThroughputBenchmark("whitespace runs (scalar)", iterations, commentHeavy.size(), [] {
+        doNotOptimize(walkRuns(commentHeavy, WHITESPACE, [](string_view text, size_t i) {
+            return scanWhitespaceScalar(text, i);
+        }));
+    });
+    runThroughputBenchmark("whitespace runs (block)", iterations, commentHeavy.size(), [] {
+        doNotOptimize(walkRuns(commentHeavy, WHITESPACE, [](string_view text, size_t i) {
+            return scanWhitespace(text, i);
+        }));
+    });
+    runThroughputBenchmark("comment bodies, to end of line (scalar)", iterations, commentHeavy.size(), [] {
+        doNotOptimize(walkUntil(commentHeavy, [](string_view text, size_t i) {
+            return scanUntilScalar(text, i, '\n');
+        }));
+    });
+    runThroughputBenchmark("comment bodies, to end of line (block)", iterations, commentHeavy.size(), [] {
+        doNotOptimize(walkUntil(commentHeavy, [](string_view text, size_t i) {
+            return scanUntil(text, i, '\n');
+        }));
+    });
+    runThroughputBenchmark("string bodies, to quote or escape (scalar)", iterations, stringHeavy.size(), [] {
+        doNotOptimize(walkUntil(stringHeavy, [](string_view text, size_t i) {
+            return scanUntilScalar(text, i, '"', '\\');
+        }));
+    });
+    runThroughputBenchmark("string bodies, to quote or escape (block)", iterations, stringHeavy.size(), [] {
+        doNotOptimize(walkUntil(stringHeavy, [](string_view text, size_t i) {
+            return scanUntil(text, i, '"', '\\');
+        }));
+    });
+
+    const vector<string_view> words = wordsOf(identifierHeavy);
+    cout << " keyword classification (" << words.size() << " words per iteration)" << endl;
+    runBenchmark("string copy + hash map + compares (before)", iterations, [&] {
+        for (const string_view word: words) {
+            doNotOptimize(legacyClassify(word));
+        }
+    });
+    runBenchmark("compile-time perfect hash (after)", iterations, [&] {
+        for (const string_view word: words) {
+            doNotOptimize(lookupKeyword(word));
+        }
+    });
+
+    cout << " whole lexer, Lexer::nextToken to end of input" << endl;
+    runThroughputBenchmark("identifier-heavy script", iterations, identifierHeavy.size(), [] {
+        doNotOptimize(lexAll(identifierHeavy));
+    });
+    runThroughputBenchmark("comment-heavy script", iterations, commentHeavy.size(), [] {
+        doNotOptimize(lexAll(commentHeavy));
+    });
+    runThroughputBenchmark("string-heavy script", iterations, stringHeavy.size(), [] {
+        doNotOptimize(lexAll(stringHeavy));
+    });
+}
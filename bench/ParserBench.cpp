@@ -0,0 +1,81 @@
+#include <string>
+#include <string_view>
+
+#include "Benchmark.h"
+#include "ast/CompilationUnit.h"
+#include "lexer/Lexer.h"
+#include "lexer/TokenStream.h"
+#include "parser/Parser.h"
+
+// Parsing throughput over generated scripts of about 1 MB. Lexing alone is measured on the same
+// input so the parser's share of the cost can be read off the difference.
+
+namespace {
+    constexpr size_t targetSize = 1 << 20;
+
+    // Repeats `pattern`, replacing every '#' with a counter so no two statements are identical
+    string generate(const string_view pattern) {
+        string text;
+        text.reserve(targetSize + 2 * pattern.size());
+        for (size_t n = 0; text.size() < targetSize; n++) {
+            for (const char c: pattern) {
+                if (c == '#') {
+                    text += to_string(n);
+                } else {
+                    text += c;
+                }
+            }
+        }
+        return text;
+    }
+
+    // Single literals and names, where every level of a precedence cascade is pure overhead
+    const string literalHeavy = generate("let v# = 1; v# = #; let s# = \"label\"; x = v#;\n");
+
+    // Long chains mixing every precedence level
+    const string operatorHeavy = generate(
+        "let e# = a# + b * 3 - c / (d + #) % 7 < f * f + 1 == g != h >= i && !j || k <= -l + m * n;\n");
+
+    // The bitwise and shift operators
+    const string bitwiseHeavy = generate(
+        "let w# = (a# & 255) << 8 | b >> 4 ^ ~c & d >>> 2 | e << # & f ^ g | h & ~i;\n");
+
+    // Calls and property accesses
+    const string callHeavy = generate("r# = first.second.third(a#, b + 1, c(d, e.f)).g(h, #);\n");
+
+    size_t lexAll(const string_view text) {
+        Lexer lexer(text);
+        size_t count = 0;
+        while (lexer.nextToken().type != TokenType::EOF_TOKEN) {
+            count++;
+        }
+        return count;
+    }
+
+    size_t parseAll(const string_view text) {
+        Lexer lexer(text);
+        TokenStream tokens(lexer);
+        Parser parser(tokens);
+        CompilationUnit unit;
+        parser.parseInto(unit);
+        return unit.statements.size();
+    }
+
+    void runScript(const string &name, const string &script) {
+        constexpr size_t iterations = 20;
+        runThroughputBenchmark(name + " (lex only)", iterations, script.size(), [&] {
+            doNotOptimize(lexAll(script));
+        });
+        runThroughputBenchmark(name + " (lex + parse)", iterations, script.size(), [&] {
+            doNotOptimize(parseAll(script));
+        });
+    }
+}
+
+void runParserBenchmarks() {
+    cout << " whole parser, Parser::parseInto over ~1 MB scripts" << endl;
+    runScript("literal-heavy script", literalHeavy);
+    runScript("operator-heavy script", operatorHeavy);
+    runScript("bitwise-heavy script", bitwiseHeavy);
+    runScript("call-heavy script", callHeavy);
+}
@@ -0,0 +1,200 @@
+#include <cmath>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include "Benchmark.h"
+#include "value/Value.h"
+
+// Per-expression cost of the arithmetic in examples/script.ys, e.g. `(4+6)*5%10;`, and the cost
+// of copying, making and concatenating string values.
+// The legacy namespace reproduces the previous representation (every value boxed on the
+// heap, every type test a dynamic_cast) so both sides can be measured in one binary.
+
+namespace legacy {
+    class Box {
+    public:
+        virtual ~Box() = default;
+    };
+
+    class DoubleBox final : public Box {
+    public:
+        explicit DoubleBox(const double value) : value(value) {
+        }
+
+        double value;
+    };
+
+    class BoolBox final : public Box {
+    };
+
+    class StringBox final : public Box {
+    public:
+        explicit StringBox(string value) : value(move(value)) {
+        }
+
+        // Copying a string value cloned its box, string buffer included
+        [[nodiscard]] StringBox *clone() const {
+            return new StringBox(*this);
+        }
+
+        string value;
+    };
+
+    class ObjectBox final : public Box {
+    };
+
+    class FunctionBox final : public Box {
+    };
+
+    class ClassBox final : public Box {
+    };
+
+    double asDouble(const Box *box) {
+        if (auto doubleBox = dynamic_cast<const DoubleBox *>(box)) {
+            return doubleBox->value;
+        }
+        throw runtime_error("Not a double value");
+    }
+
+    // Mirrors the chain of type tests in Interpreter::setLastValue
+    bool isSupported(const Box *box) {
+        return dynamic_cast<const DoubleBox *>(box) || dynamic_cast<const BoolBox *>(box) ||
+               dynamic_cast<const StringBox *>(box) || dynamic_cast<const ObjectBox *>(box) ||
+               dynamic_cast<const FunctionBox *>(box) || dynamic_cast<const ClassBox *>(box);
+    }
+}
+
+namespace {
+    enum class Op { ADD, MULTIPLY, DIVIDE, MODULO };
+
+    struct Step {
+        double left;
+        Op op;
+        double right;
+    };
+
+    // (4+6)*5%10 followed by 5/4, flattened into the binary operations the interpreter performs
+    const vector<Step> steps = {
+        {4, Op::ADD, 6}, {10, Op::MULTIPLY, 5}, {50, Op::MODULO, 10}, {5, Op::DIVIDE, 4},
+    };
+
+    double apply(const Op op, const double left, const double right) {
+        switch (op) {
+            case Op::ADD: return left + right;
+            case Op::MULTIPLY: return left * right;
+            case Op::DIVIDE: return left / right;
+            case Op::MODULO: return fmod(left, right);
+        }
+        return 0;
+    }
+
+    bool isSupported(const Value &value) {
+        return value.isDouble() || value.isBool() || value.isString() || value.isObject() ||
+               value.isFunction() || value.isClass() || value.isNull();
+    }
+}
+
+void runValueBenchmarks() {
+    constexpr size_t iterations = 2'000'000;
+
+    vector<unique_ptr<legacy::Box> > legacyOperands;
+    vector<Value> operands;
+    for (const Step &step: steps) {
+        legacyOperands.push_back(make_unique<legacy::DoubleBox>(step.left));
+        legacyOperands.push_back(make_unique<legacy::DoubleBox>(step.right));
+        operands.emplace_back(step.left);
+        operands.emplace_back(step.right);
+    }
+
+    cout << " type dispatch only (" << steps.size() << " operations per iteration)" << endl;
+    runBenchmark("dynamic_cast dispatch (before)", iterations, [&] {
+        double sum = 0;
+        for (size_t i = 0; i < steps.size(); i++) {
+            const legacy::Box *left = legacyOperands[2 * i].get();
+            const legacy::Box *right = legacyOperands[2 * i + 1].get();
+            doNotOptimize(legacy::isSupported(left) && legacy::isSupported(right));
+            sum += apply(steps[i].op, legacy::asDouble(left), legacy::asDouble(right));
+        }
+        doNotOptimize(sum);
+    });
+    runBenchmark("tag dispatch (after)", iterations, [&] {
+        double sum = 0;
+        for (size_t i = 0; i < steps.size(); i++) {
+            const Value &left = operands[2 * i];
+            const Value &right = operands[2 * i + 1];
+            doNotOptimize(isSupported(left) && isSupported(right));
+            sum += apply(steps[i].op, left.asDouble(), right.asDouble());
+        }
+        doNotOptimize(sum);
+    });
+
+    cout << " full binary operation, including the boxed result" << endl;
+    runBenchmark("heap-boxed result + dynamic_cast (before)", iterations, [&] {
+        for (size_t i = 0; i < steps.size(); i++) {
+            const legacy::Box *left = legacyOperands[2 * i].get();
+            const legacy::Box *right = legacyOperands[2 * i + 1].get();
+            auto result = make_shared<legacy::DoubleBox>(apply(steps[i].op, legacy::asDouble(left),
+                                                               legacy::asDouble(right)));
+            doNotOptimize(legacy::isSupported(result.get()));
+            doNotOptimize(result);
+        }
+    });
+    runBenchmark("inline result + tag dispatch (after)", iterations, [&] {
+        for (size_t i = 0; i < steps.size(); i++) {
+            const Value &left = operands[2 * i];
+            const Value &right = operands[2 * i + 1];
+            auto result = make_shared<Value>(apply(steps[i].op, left.asDouble(), right.asDouble()));
+            doNotOptimize(isSupported(*result));
+            doNotOptimize(result);
+        }
+    });
+
+    // Longer than the small-string buffer, so a deep copy allocates twice
+    const string text = "the quick brown fox jumps over the lazy dog";
+    cout << " copying a string value, as reading a string variable does" << endl;
+    const legacy::StringBox legacyString(text);
+    runBenchmark("cloned box (before)", iterations, [&] {
+        const unique_ptr<legacy::StringBox> copy(legacyString.clone());
+        doNotOptimize(copy);
+    });
+    const Value stringValue(text);
+    runBenchmark("shared box (after)", iterations, [&] {
+        const Value copy(stringValue);
+        doNotOptimize(copy);
+    });
+
+    const string shortText = "short";
+    cout << " making a short string value, as a literal or a small concatenation does" << endl;
+    runBenchmark("boxed (before)", iterations, [&] {
+        const auto box = make_unique<legacy::StringBox>(shortText);
+        doNotOptimize(box);
+    });
+    runBenchmark("inline (after)", iterations, [&] {
+        const Value value(shortText);
+        doNotOptimize(value);
+    });
+
+    // Appends a 256-byte piece until the string reaches `size` bytes, then reads it once, as
+    // printing it would. Copying both operands on every append makes the whole build quadratic.
+    const string piece(256, '*');
+    cout << " building a string by appending to it, in MB of result per second" << endl;
+    constexpr size_t copiedSize = 1 << 20; // Larger ones take minutes
+    runThroughputBenchmark("copying concatenation, 1 MB (before)", 1, copiedSize, [&] {
+        auto built = make_unique<legacy::StringBox>("");
+        while (built->value.size() < copiedSize) {
+            built = make_unique<legacy::StringBox>(built->value + piece);
+        }
+        doNotOptimize(built->value.data());
+    });
+    const Value pieceValue(piece);
+    for (const size_t size: {1 << 20, 4 << 20, 16 << 20}) {
+        runThroughputBenchmark("rope concatenation, " + to_string(size >> 20) + " MB (after)", 3, size, [&] {
+            Value built(string{});
+            for (size_t length = 0; length < size; length += piece.size()) {
+                built = Value::concatenate(built, pieceValue);
+            }
+            doNotOptimize(built.asString().data());
+        });
+    }
+}
@@ -0,0 +1,80 @@
+#ifndef SYMBOL_H
+#define SYMBOL_H
+
+#include <functional>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+
+using namespace std;
+
+
+// An interned name. The Lexer interns every identifier and string literal once, and equal
+// names share a single table entry, so comparing or hashing a Symbol is a pointer operation.
+class Symbol {
+public:
+    Symbol() : name_(&emptyName) {
+    }
+
+    // Returns the unique Symbol for `text`, adding it to the table on first use. Safe to call from
+    // several threads: lookups of names already interned share the lock, only insertions take it alone.
+    static Symbol intern(const string_view text) {
+        if (text.empty()) {
+            return {};
+        }
+        static unordered_set<string, TextHash, equal_to<> > table;
+        static shared_mutex mutex;
+        {
+            shared_lock lock(mutex);
+            const auto it = table.find(text);
+            if (it != table.end()) {
+                return Symbol(&*it);
+            }
+        }
+        unique_lock lock(mutex);
+        return Symbol(&*table.emplace(text).first); // Finds the entry if another thread added it meanwhile
+    }
+
+    [[nodiscard]] const string &str() const {
+        return *name_;
+    }
+
+    bool operator==(const Symbol other) const {
+        return name_ == other.name_;
+    }
+
+    // Orders by table address, not alphabetically; only meant for ordered containers
+    bool operator<(const Symbol other) const {
+        return name_ < other.name_;
+    }
+
+private:
+    // Heterogeneous hash so lookups by string_view do not build a temporary string
+    struct TextHash {
+        using is_transparent = void;
+
+        size_t operator()(const string_view text) const {
+            return hash<string_view>()(text);
+        }
+    };
+
+    inline static const string emptyName;
+
+    const string *name_;
+
+    explicit Symbol(const string *name) : name_(name) {
+    }
+
+    friend struct std::hash<Symbol>;
+};
+
+template<>
+struct std::hash<Symbol> {
+    size_t operator()(const Symbol symbol) const noexcept {
+        return hash<const string *>()(symbol.name_);
+    }
+};
+
+#endif //SYMBOL_H
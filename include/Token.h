@@ -4,12 +4,16 @@
 
 #ifndef TOKEN_H
 #define TOKEN_H
+#include <cstddef>
+#include <cstdint>
 #include <string>
 
+#include "Symbol.h"
+
 using namespace std;
 
 
-enum class TokenType {
+enum class TokenType : uint8_t {
     // Keywords
     IF, ELSE, SWITCH, CASE, DEFAULT, FOR, WHILE, DO, BREAK, CONTINUE, RETURN, TRY, CATCH, FINALLY, THROW, NEW, DELETE,
 
@@ -42,12 +46,34 @@ enum class TokenType {
     UNKNOWN,
 };
 
-struct Token {
-    TokenType type;
-    string value;
+// Line and column of a source offset, both starting at 1
+struct SourceLocation {
     int line;
     int column;
 };
 
+// A token is a span of the source buffer plus the decoded value of literals and names, packed into
+// 16 bytes. The text and the line/column of a token are looked up through the Lexer that produced it.
+struct Token {
+    static constexpr size_t MAX_LENGTH = (1 << 24) - 1;
+
+    uint32_t offset = 0; // Start of the lexeme in the source
+    TokenType type = TokenType::UNKNOWN;
+    uint32_t length : 24 = 0; // Shares a word with `type`
+
+    union {
+        double number; // Value of a DOUBLE_LITERAL, converted once by the Lexer
+        Symbol symbol; // Interned value of identifiers and string literals
+    };
+
+    Token() : number(0) {
+    }
+
+    Token(const TokenType type, const size_t offset, const size_t length)
+        : offset(static_cast<uint32_t>(offset)), type(type), length(static_cast<uint32_t>(length)), number(0) {
+    }
+};
+
+static_assert(sizeof(Token) == 16);
 
 #endif //TOKEN_H
@@ -1,64 +1,365 @@
+#include <charconv>
+#include <chrono>
+#include <filesystem>
+#include <iomanip>
 #include <iostream>
-#include <fstream>
-#include <sstream>
+#include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 #include "src/lexer/Lexer.h"
+#include "src/lexer/SourceFile.h"
+#include "src/lexer/TokenStream.h"
 #include "src/parser/Parser.h"
 #include "src/interpreter/Interpreter.h"
 #include "include/Token.h"
 #include "src/ast/AST.h"
-#include "src/ast/AST.h"
+#include "src/ast/CompilationUnit.h"
+#include "src/ast/FlatAST.h"
 #include "src/interpreter/Interpreter.h"
 #include "src/parser/Parser.h"
+#include "src/compiler/Compiler.h"
+#include "src/resolver/Resolver.h"
+#include "src/vm/VM.h"
+#include "src/concurrency/ThreadPool.h"
+#include "src/cache/ProgramCache.h"
+#include "src/optimizer/ConstantFolder.h"
+#include "src/gc/Heap.h"
+
+// Runs a parsed program on the engine chosen by the flags and returns the exit status. Given a
+// cache, the bytecode or flat program is also stored there for the next run of the same source.
+static int execute(const vector<unique_ptr<Statement> > &statements, const bool useVM, const bool useFlat,
+                   const ProgramCache *cache = nullptr, const string_view source = {}) {
+    if (useVM) {
+        Chunk chunk;
+        try {
+            chunk = Compiler().compile(statements);
+        } catch (const runtime_error &error) {
+            cerr << "Compile error: " << error.what() << endl;
+            return 1;
+        }
+        if (cache) {
+            cache->store(source, chunk);
+        }
+        VM vm;
+        vm.run(chunk);
+    } else {
+        try {
+            Resolver().resolve(statements);
+        } catch (const runtime_error &error) {
+            cerr << "Resolve error: " << error.what() << endl;
+            return 1;
+        }
+        Interpreter interpreter;
+        if (useFlat) {
+            FlatProgram program = Flattener().flatten(statements);
+            if (cache) {
+                cache->store(source, program);
+            }
+            interpreter.interpret(program);
+        } else {
+            interpreter.interpret(statements);
+        }
+    }
+
+    return 0;
+}
+
+// Runs the program cached for `source`, if there is one, skipping the lexer and the parser.
+// Returns false on a cache miss.
+static bool runCached(const ProgramCache &cache, const string_view source, const bool useVM) {
+    if (useVM) {
+        Chunk chunk;
+        if (!cache.load(source, chunk)) {
+            return false;
+        }
+        cout << "Loaded cached bytecode from " << cache.getDirectory() << endl;
+        VM vm;
+        vm.run(chunk);
+        return true;
+    }
+
+    FlatProgram program;
+    if (!cache.load(source, program)) {
+        return false;
+    }
+    cout << "Loaded cached flat program from " << cache.getDirectory() << endl;
+    Interpreter interpreter;
+    interpreter.interpret(program);
+    return true;
+}
+
+// One script of a batch run. The source stays mapped as long as the tokens and the AST use it.
+struct BatchFile {
+    string path;
+    unique_ptr<SourceFile> source;
+    CompilationUnit unit;
+    string loadError;
+    double parseMilliseconds = 0; // Including constant folding
+    double runMilliseconds = 0;
+    size_t foldedNodes = 0;
+};
+
+static double millisecondsSince(const chrono::steady_clock::time_point start) {
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+// Lexes and parses every file concurrently, each with its own Lexer, Parser and arena, then runs
+// them one after another in the order given, so their output does not interleave
+static int runBatch(const vector<const char *> &paths, const size_t jobs, const bool useVM, const bool useFlat,
+                    const bool foldConstants) {
+    vector<unique_ptr<BatchFile> > files;
+    for (const char *path: paths) {
+        files.push_back(make_unique<BatchFile>());
+        files.back()->path = path;
+    }
+
+    const auto parseStart = chrono::steady_clock::now();
+    size_t threadCount;
+    {
+        ThreadPool pool(jobs == 0 ? thread::hardware_concurrency() : jobs);
+        threadCount = pool.getThreadCount();
+        for (const unique_ptr<BatchFile> &file: files) {
+            pool.submit([&file = *file, foldConstants] {
+                const auto start = chrono::steady_clock::now();
+                try {
+                    file.source = make_unique<SourceFile>(file.path);
+                } catch (const runtime_error &error) {
+                    file.loadError = error.what();
+                    return;
+                }
+                Lexer lexer(file.source->text());
+                TokenStream tokens(lexer);
+                Parser(tokens).parseInto(file.unit);
+                if (foldConstants && !file.unit.hasErrors()) {
+                    file.foldedNodes = ConstantFolder().fold(file.unit);
+                }
+                file.parseMilliseconds = millisecondsSince(start);
+            });
+        }
+        pool.wait();
+    }
+    const double parseWallMilliseconds = millisecondsSince(parseStart);
+
+    size_t failed = 0;
+    for (const unique_ptr<BatchFile> &file: files) {
+        cout << "\n== " << file->path << " ==" << endl;
+        if (!file->loadError.empty()) {
+            cerr << file->loadError << endl;
+            failed++;
+            continue;
+        }
+        for (const Diagnostic &diagnostic: file->unit.diagnostics) {
+            cerr << diagnostic.format(file->source->text()) << endl;
+        }
+        if (file->unit.hasErrors()) {
+            cerr << "Parsing failed with " << file->unit.diagnostics.size() << " error(s)." << endl;
+            failed++;
+            continue;
+        }
+        const auto runStart = chrono::steady_clock::now();
+        if (execute(file->unit.statements, useVM, useFlat) != 0) {
+            failed++;
+        }
+        file->runMilliseconds = millisecondsSince(runStart);
+    }
+
+    // Per-file timings, then the totals: with more than one thread, the parse wall time should
+    // come out well below the summed parse times
+    double parseTotal = 0;
+    double runTotal = 0;
+    size_t foldedTotal = 0;
+    cout << "\nBatch of " << files.size() << " file(s) on " << threadCount << " thread(s)" << endl;
+    cout << fixed << setprecision(3);
+    for (const unique_ptr<BatchFile> &file: files) {
+        const bool ok = file->loadError.empty() && !file->unit.hasErrors();
+        cout << "  " << file->path << ": parse " << file->parseMilliseconds << " ms, run " << file->runMilliseconds
+                << " ms" << (ok ? "" : " (failed)") << endl;
+        parseTotal += file->parseMilliseconds;
+        runTotal += file->runMilliseconds;
+        foldedTotal += file->foldedNodes;
+    }
+    cout << "  parse: " << parseWallMilliseconds << " ms wall, " << parseTotal << " ms summed over files" << endl;
+    cout << "  run: " << runTotal << " ms" << endl;
+    cout << "  constant folding removed " << foldedTotal << " node(s)" << endl;
+    cout << "  " << files.size() - failed << " passed, " << failed << " failed" << endl;
+    return failed == 0 ? 0 : 1;
+}
+
+static constexpr auto USAGE =
+        "Usage: Yolo [--vm | --flat] [--tokens] [--no-fold] [--gc-stats] [--gc-pause-budget MS] "
+        "[--cache | --cache-dir DIR] [--jobs N] [file...]";
+
+static int usageError(const string &message) {
+    cerr << message << endl << USAGE << endl;
+    return 1;
+}
+
+// Parses all of `text` as a number, rejecting anything trailing it
+template<typename T>
+static bool parseNumber(const string_view text, T &value) {
+    const auto [end, ec] = from_chars(text.data(), text.data() + text.size(), value);
+    return ec == errc() && end == text.data() + text.size();
+}
 
 int main(int argc, char *argv[]) {
     string sourceCode{"let arr = Array.create(); arr.push(1);"};
 
+    // See USAGE for the flags. --vm runs the program on the bytecode VM instead of the tree walker, --flat runs the
+    // tree walker over the flattened, index-addressed AST, --tokens prints every token, --no-fold skips constant
+    // folding, --gc-stats prints the garbage collector's statistics at exit, --gc-pause-budget caps each increment
+    // of an old generation collection at MS milliseconds. --cache keeps the bytecode or flat program of a script in
+    // .yolo-cache next to it (or in DIR) and reuses it while the script is unchanged. Given several files, Yolo
+    // parses them in parallel on N threads (default: one per core), then runs them; --tokens and --cache take a
+    // single file.
+    bool useVM = false;
+    bool useFlat = false;
+    bool dumpTokens = false;
+    bool useCache = false;
+    bool foldConstants = true;
+    bool gcStats = false;
+    string cacheDirectory;
+    size_t jobs = 0;
+    vector<const char *> paths;
+    for (int i = 1; i < argc; i++) {
+        if (string(argv[i]) == "--vm") {
+            useVM = true;
+        } else if (string(argv[i]) == "--flat") {
+            useFlat = true;
+        } else if (string(argv[i]) == "--tokens") {
+            dumpTokens = true;
+        } else if (string(argv[i]) == "--no-fold") {
+            foldConstants = false;
+        } else if (string(argv[i]) == "--gc-stats") {
+            gcStats = true;
+        } else if (string(argv[i]) == "--gc-pause-budget") {
+            double budget;
+            if (i + 1 == argc || !parseNumber(argv[++i], budget) || budget < 0) {
+                return usageError("--gc-pause-budget expects a number of milliseconds.");
+            }
+            Heap::current().setPauseBudget(budget);
+        } else if (string(argv[i]) == "--cache") {
+            useCache = true;
+        } else if (string(argv[i]) == "--cache-dir") {
+            if (i + 1 == argc) {
+                return usageError("--cache-dir expects a directory.");
+            }
+            useCache = true;
+            cacheDirectory = argv[++i];
+        } else if (string(argv[i]) == "--jobs") {
+            if (i + 1 == argc || !parseNumber(argv[++i], jobs) || jobs == 0) {
+                return usageError("--jobs expects a positive number of threads.");
+            }
+        } else {
+            paths.push_back(argv[i]);
+        }
+    }
+
+    // Refuse combinations that would otherwise be quietly ignored
+    if (useVM && useFlat) {
+        return usageError("--vm and --flat choose different engines; pass only one.");
+    }
+    if (useCache && !useVM && !useFlat) {
+        return usageError("--cache only applies to --vm and --flat; the tree walker has nothing to cache.");
+    }
+    if (useCache && paths.empty()) {
+        return usageError("--cache needs a script file.");
+    }
+
+    // Every engine allocates on the main thread's heap, so its statistics cover the whole run
+    struct GcStatsPrinter {
+        bool enabled;
+
+        ~GcStatsPrinter() {
+            if (enabled) {
+                Heap::current().getStats().print(cout);
+            }
+        }
+    } gcStatsPrinter{gcStats};
+
+    if (paths.size() > 1) {
+        // A batch parses on worker threads and reports its own timings; it neither dumps tokens nor
+        // uses the cache, so refuse those flags rather than ignoring them
+        if (dumpTokens || useCache) {
+            return usageError(string(dumpTokens ? "--tokens" : "--cache") + " takes a single file.");
+        }
+        return runBatch(paths, jobs, useVM, useFlat, foldConstants);
+    }
+    const char *path = paths.empty() ? nullptr : paths.front();
+
     // Check if a file was provided
-    if (argc > 1) {
-        ifstream file(argv[1]);
-        if (!file) {
-            cerr << "Could not open file: " << argv[1] << endl;
+    unique_ptr<SourceFile> sourceFile;
+    string_view source = sourceCode;
+    if (path) {
+        // Map the file rather than copying it; tokens point straight into the mapping
+        try {
+            sourceFile = make_unique<SourceFile>(path);
+        } catch (const runtime_error &error) {
+            cerr << error.what() << endl;
             return 1;
         }
-
-        // Read the file contents into the sourceCode string
-        stringstream buffer;
-        buffer << file.rdbuf();
-        sourceCode = buffer.str();
-        file.close();
+        source = sourceFile->text();
     } else {
         // If no file is provided, fallback to standard input
         cout << "Enter your code > " << endl;
         // getline(cin, sourceCode);
     }
 
-    // 1. Tokenize the source code
-    Lexer lexer(sourceCode);
-    vector<Token> tokens = lexer.tokenize();
+    // 1. Optional: Print tokens for debugging. This lexes the source separately so the parse below
+    // can still stream tokens instead of holding them all.
+    if (dumpTokens) {
+        Lexer dumpLexer(source);
+        TokenStream dump(dumpLexer);
+        while (true) {
+            const Token &token = dump.peek();
+            const SourceLocation location = dump.locate(token);
+            cout << "Token(Type: " << static_cast<int>(token.type) << ", Value: '" << dump.text(token) << "', Line: " <<
+                    location.line << ", Column: " << location.column << ")" << endl;
+            if (token.type == TokenType::EOF_TOKEN) {
+                break;
+            }
+            dump.advance();
+        }
+    }
 
-    // Optional: Print tokens for debugging
-    for (const Token &token: tokens) {
-        cout << "Token(Type: " << static_cast<int>(token.type) << ", Value: '" << token.value << "', Line: " << token.
-                line << ", Column: " << token.column << ")" << endl;
+    // 2. An unchanged script runs straight from the program its last run cached. The tree walker runs the
+    // pointer-based AST, which has no cached form, so --cache was only accepted with --vm or --flat.
+    unique_ptr<ProgramCache> cache;
+    if (useCache) {
+        if (cacheDirectory.empty()) {
+            cacheDirectory = (filesystem::path(path).parent_path() / ".yolo-cache").string();
+        }
+        cache = make_unique<ProgramCache>(cacheDirectory, foldConstants);
+        if (runCached(*cache, source, useVM)) {
+            return 0;
+        }
     }
 
-    // 2. Parse the tokens into an AST
+    // 3. Parse the tokens into an AST, lexing them on demand
     cout << "\nStarting to parse tokens..." << endl;
+    // The unit's arena owns every node, so the whole tree is released in one go when it goes out of scope
+    Lexer lexer(source);
+    TokenStream tokens(lexer);
     Parser parser(tokens);
-    vector<unique_ptr<Statement> > statements;
-    try {
-        statements = parser.parse();
-        cout << "Parsing successful!" << endl;
-    } catch (const runtime_error &error) {
-        cerr << "Parsing error: " << error.what() << endl;
+    CompilationUnit unit;
+    const vector<unique_ptr<Statement> > &statements = unit.statements;
+    parser.parseInto(unit);
+    // Report every problem in the file at once; statements with errors were left out, so don't run the rest
+    for (const Diagnostic &diagnostic: unit.diagnostics) {
+        cerr << diagnostic.format(source) << endl;
+    }
+    if (unit.hasErrors()) {
+        cerr << "Parsing failed with " << unit.diagnostics.size() << " error(s)." << endl;
         return 1;
     }
+    cout << "Parsing successful!" << endl;
 
-    // 3. Interpret the AST
-    Interpreter interpreter;
-    interpreter.interpret(statements);
+    // 4. Fold constant expressions and drop branches that can never run
+    if (foldConstants) {
+        const size_t removed = ConstantFolder().fold(unit);
+        cout << "Constant folding removed " << removed << " node(s)." << endl;
+    }
 
-    return 0;
+    // 5. Execute the AST, either directly or as compiled bytecode
+    return execute(statements, useVM, useFlat, cache.get(), source);
 }
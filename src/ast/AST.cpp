@@ -9,7 +9,7 @@
 // ********************
 
 
-std::shared_ptr<Value> LiteralExpression::accept(Visitor &visitor) {
+Value LiteralExpression::accept(Visitor &visitor) {
     cout << "LiteralExpression::accept(Visitor &visitor)" << endl;
     return visitor.visitLiteralExpression(this);
 }
@@ -23,19 +23,32 @@ TokenType LiteralExpression::getType() const {
 // IdentifierExpression
 // ********************
 
-IdentifierExpression::IdentifierExpression(string name)
-    : name_(move(name)) {
+IdentifierExpression::IdentifierExpression(const Symbol name)
+    : name_(name) {
 }
 
-std::shared_ptr<Value> IdentifierExpression::accept(Visitor &visitor) {
+Value IdentifierExpression::accept(Visitor &visitor) {
     cout << "IdentifierExpression::accept(Visitor &visitor)" << endl;
     return visitor.visitIdentifierExpression(this);
 }
 
-const string &IdentifierExpression::getName() const {
+Symbol IdentifierExpression::getName() const {
     return name_;
 }
 
+void IdentifierExpression::resolve(const int depth, const int slot) {
+    depth_ = depth;
+    slot_ = slot;
+}
+
+int IdentifierExpression::getDepth() const {
+    return depth_;
+}
+
+int IdentifierExpression::getSlot() const {
+    return slot_;
+}
+
 // ********************
 // BinaryExpression
 // ********************
@@ -44,7 +57,7 @@ BinaryExpression::BinaryExpression(unique_ptr<Expression> left, Operator op, uni
     : left_(move(left)), op_(op), right_(move(right)) {
 }
 
-std::shared_ptr<Value> BinaryExpression::accept(Visitor &visitor) {
+Value BinaryExpression::accept(Visitor &visitor) {
     cout << "BinaryExpression::accept(Visitor &visitor)" << endl;
     return visitor.visitBinaryExpression(this);
 }
@@ -61,6 +74,14 @@ Expression *BinaryExpression::getRight() const {
     return right_.get();
 }
 
+BinaryExpression::Specialization BinaryExpression::getSpecialization() const {
+    return specialization_;
+}
+
+void BinaryExpression::specialize(const Specialization specialization) {
+    specialization_ = specialization;
+}
+
 // ********************
 // UnaryExpression
 // ********************
@@ -69,7 +90,7 @@ UnaryExpression::UnaryExpression(Operator op, unique_ptr<Expression> right)
     : op_(op), right_(move(right)) {
 }
 
-std::shared_ptr<Value> UnaryExpression::accept(Visitor &visitor) {
+Value UnaryExpression::accept(Visitor &visitor) {
     cout << "UnaryExpression::accept(Visitor &visitor)" << endl;
     return visitor.visitUnaryExpression(this);
 }
@@ -86,16 +107,16 @@ Expression *UnaryExpression::getRight() const {
 // AssignmentExpression
 // ********************
 
-AssignmentExpression::AssignmentExpression(string name, unique_ptr<Expression> value, TokenType op)
-    : name_(move(name)), value_(move(value)), op_(op) {
+AssignmentExpression::AssignmentExpression(const Symbol name, unique_ptr<Expression> value, TokenType op)
+    : name_(name), value_(move(value)), op_(op) {
 }
 
-std::shared_ptr<Value> AssignmentExpression::accept(Visitor &visitor) {
+Value AssignmentExpression::accept(Visitor &visitor) {
     cout << "AssignmentExpression::accept(Visitor &visitor)" << endl;
     return visitor.visitAssignmentExpression(this);
 }
 
-const string &AssignmentExpression::getName() const {
+Symbol AssignmentExpression::getName() const {
     return name_;
 }
 
@@ -107,6 +128,19 @@ TokenType AssignmentExpression::getOperator() const {
     return op_;
 }
 
+void AssignmentExpression::resolve(const int depth, const int slot) {
+    depth_ = depth;
+    slot_ = slot;
+}
+
+int AssignmentExpression::getDepth() const {
+    return depth_;
+}
+
+int AssignmentExpression::getSlot() const {
+    return slot_;
+}
+
 // ********************
 // LogicalExpression
 // ********************
@@ -115,7 +149,7 @@ LogicalExpression::LogicalExpression(unique_ptr<Expression> left, Operator op, u
     : left_(move(left)), op_(op), right_(move(right)) {
 }
 
-std::shared_ptr<Value> LogicalExpression::accept(Visitor &visitor) {
+Value LogicalExpression::accept(Visitor &visitor) {
     cout << "LogicalExpression::accept(Visitor &visitor)" << endl;
     return visitor.visitLogicalExpression(this);
 }
@@ -140,7 +174,7 @@ FunctionCallExpression::FunctionCallExpression(unique_ptr<Expression> callee, ve
     : callee_(move(callee)), arguments_(move(arguments)) {
 }
 
-std::shared_ptr<Value> FunctionCallExpression::accept(Visitor &visitor) {
+Value FunctionCallExpression::accept(Visitor &visitor) {
     cout << "FunctionCallExpression::accept(Visitor &visitor)" << endl;
     return visitor.visitFunctionCallExpression(this);
 }
@@ -157,11 +191,11 @@ const vector<unique_ptr<Expression> > &FunctionCallExpression::getArguments() co
 // GetExpression
 // ********************
 
-GetExpression::GetExpression(unique_ptr<Expression> object, string name)
-    : object_(move(object)), name_(move(name)) {
+GetExpression::GetExpression(unique_ptr<Expression> object, const Symbol name)
+    : object_(move(object)), name_(name) {
 }
 
-std::shared_ptr<Value> GetExpression::accept(Visitor &visitor) {
+Value GetExpression::accept(Visitor &visitor) {
     cout << "GetExpression::accept(Visitor &visitor)" << endl;
     return visitor.visitGetExpression(this);
 }
@@ -170,10 +204,14 @@ Expression *GetExpression::getObject() const {
     return object_.get();
 }
 
-const string &GetExpression::getName() const {
+Symbol GetExpression::getName() const {
     return name_;
 }
 
+InlineCache &GetExpression::getCache() {
+    return cache_;
+}
+
 // ********************
 // ExpressionStatement
 // ********************
@@ -182,7 +220,7 @@ ExpressionStatement::ExpressionStatement(unique_ptr<Expression> expression)
     : expression_(move(expression)) {
 }
 
-std::shared_ptr<Value> ExpressionStatement::accept(Visitor &visitor) {
+Value ExpressionStatement::accept(Visitor &visitor) {
     cout << "ExpressionStatement::accept(Visitor &visitor)" << endl;
     visitor.visitExpressionStatement(this);
     return {};
@@ -196,17 +234,17 @@ Expression *ExpressionStatement::getExpression() const {
 // VariableDeclaration
 // ********************
 
-VariableDeclaration::VariableDeclaration(string name, string typeName, unique_ptr<Expression> initializer)
-    : name_(move(name)), typeName_(move(typeName)), initializer_(move(initializer)) {
+VariableDeclaration::VariableDeclaration(const Symbol name, string typeName, unique_ptr<Expression> initializer)
+    : name_(name), typeName_(move(typeName)), initializer_(move(initializer)) {
 }
 
-std::shared_ptr<Value> VariableDeclaration::accept(Visitor &visitor) {
+Value VariableDeclaration::accept(Visitor &visitor) {
     cout << "VariableDeclaration::accept(Visitor &visitor)" << endl;
     visitor.visitVariableDeclaration(this);
     return {};
 }
 
-const string &VariableDeclaration::getName() const {
+Symbol VariableDeclaration::getName() const {
     return name_;
 }
 
@@ -218,6 +256,14 @@ Expression *VariableDeclaration::getInitializer() const {
     return initializer_.get();
 }
 
+void VariableDeclaration::setSlot(const int slot) {
+    slot_ = slot;
+}
+
+int VariableDeclaration::getSlot() const {
+    return slot_;
+}
+
 // ********************
 // BlockStatement
 // ********************
@@ -226,7 +272,7 @@ BlockStatement::BlockStatement(vector<unique_ptr<Statement> > statements)
     : statements_(move(statements)) {
 }
 
-std::shared_ptr<Value> BlockStatement::accept(Visitor &visitor) {
+Value BlockStatement::accept(Visitor &visitor) {
     cout << "BlockStatement::accept(Visitor &visitor)" << endl;
     visitor.visitBlockStatement(this);
     return {};
@@ -245,7 +291,7 @@ IfStatement::IfStatement(unique_ptr<Expression> condition, unique_ptr<Statement>
     : condition_(move(condition)), thenBranch_(move(thenBranch)), elseBranch_(move(elseBranch)) {
 }
 
-std::shared_ptr<Value> IfStatement::accept(Visitor &visitor) {
+Value IfStatement::accept(Visitor &visitor) {
     cout << "IfStatement::accept(Visitor &visitor)" << endl;
     visitor.visitIfStatement(this);
     return {};
@@ -271,7 +317,7 @@ WhileStatement::WhileStatement(unique_ptr<Expression> condition, unique_ptr<Stat
     : condition_(move(condition)), body_(move(body)) {
 }
 
-std::shared_ptr<Value> WhileStatement::accept(Visitor &visitor) {
+Value WhileStatement::accept(Visitor &visitor) {
     cout << "WhileStatement::accept(Visitor &visitor)" << endl;
     visitor.visitWhileStatement(this);
     return {};
@@ -293,7 +339,7 @@ ReturnStatement::ReturnStatement(unique_ptr<Expression> value)
     : value_(move(value)) {
 }
 
-std::shared_ptr<Value> ReturnStatement::accept(Visitor &visitor) {
+Value ReturnStatement::accept(Visitor &visitor) {
     cout << "ReturnStatement::accept(Visitor &visitor)" << endl;
     visitor.visitReturnStatement(this);
     return {};
@@ -307,18 +353,18 @@ Expression *ReturnStatement::getValue() const {
 // FunctionDeclaration
 // ********************
 
-FunctionDeclaration::FunctionDeclaration(string name, vector<Parameter> parameters, string returnTypeName,
+FunctionDeclaration::FunctionDeclaration(const Symbol name, vector<Parameter> parameters, string returnTypeName,
                                          unique_ptr<BlockStatement> body)
-    : name_(move(name)), parameters_(move(parameters)), returnTypeName_(move(returnTypeName)), body_(move(body)) {
+    : name_(name), parameters_(move(parameters)), returnTypeName_(move(returnTypeName)), body_(move(body)) {
 }
 
-std::shared_ptr<Value> FunctionDeclaration::accept(Visitor &visitor) {
+Value FunctionDeclaration::accept(Visitor &visitor) {
     cout << "FunctionDeclaration::accept(Visitor &visitor)" << endl;
     visitor.visitFunctionDeclaration(this);
     return {};
 }
 
-const string &FunctionDeclaration::getName() const {
+Symbol FunctionDeclaration::getName() const {
     return name_;
 }
 
@@ -1,6 +1,7 @@
 #ifndef AST_H
 #define AST_H
 
+#include <cstdint>
 #include <string>
 #include <utility>
 #include <vector>
@@ -8,12 +9,16 @@
 
 #include "../visitor/Visitor.h"
 #include "../../include/Token.h"
+#include "../../include/Symbol.h"
 #include "value/Value.h"
+#include "object/InlineCache.h"
+#include "Arena.h"
 
 
 using namespace std;
 class ValueType;
 class Visitor;
+class ConstantFolder; // Rewrites the children of the nodes that befriend it in place
 
 // Forward declaration for Visitor
 
@@ -22,7 +27,15 @@ class ASTNode {
 public:
     virtual ~ASTNode() = default;
 
-    virtual std::shared_ptr<Value> accept(Visitor &visitor) = 0;
+    // Nodes live in the active Arena (see CompilationUnit) and are released with it, never one by one
+    static void *operator new(const size_t size) {
+        return Arena::current().allocate(size);
+    }
+
+    static void operator delete(void *) noexcept {
+    }
+
+    virtual Value accept(Visitor &visitor) = 0;
 };
 
 // ********************
@@ -35,35 +48,44 @@ public:
 
 class LiteralExpression : public Expression {
 public:
-    LiteralExpression(const TokenType type, shared_ptr<ValueType> value)
+    LiteralExpression(const TokenType type, Value value)
         : type_(type), value_(move(value)) {
     }
 
 
-    std::shared_ptr<Value> accept(Visitor &visitor) override;
+    Value accept(Visitor &visitor) override;
 
     [[nodiscard]] TokenType getType() const;
 
-    [[nodiscard]] shared_ptr<ValueType> getValue() const {
+    [[nodiscard]] const Value &getValue() const {
         return value_;
     }
 
 private:
     TokenType type_;
-    shared_ptr<ValueType> value_;
+    Value value_;
 };
 
 // Identifier expressions
 class IdentifierExpression final : public Expression {
 public:
-    explicit IdentifierExpression(string name);
+    explicit IdentifierExpression(Symbol name);
 
-    std::shared_ptr<Value> accept(Visitor &visitor) override;
+    Value accept(Visitor &visitor) override;
 
-    [[nodiscard]] const string &getName() const;
+    [[nodiscard]] Symbol getName() const;
+
+    // Set by the Resolver: scopes to walk up and the slot in that scope. Unresolved names keep depth -1
+    void resolve(int depth, int slot);
+
+    [[nodiscard]] int getDepth() const;
+
+    [[nodiscard]] int getSlot() const;
 
 private:
-    string name_;
+    Symbol name_;
+    int depth_ = -1;
+    int slot_ = -1;
 };
 
 // Binary expressions
@@ -74,12 +96,25 @@ public:
         EQUAL, NOT_EQUAL, STRICT_EQUAL, STRICT_NOT_EQUAL,
         LESS, LESS_EQUAL, GREATER, GREATER_EQUAL,
         LOGICAL_AND, LOGICAL_OR,
+        BITWISE_AND, BITWISE_OR, BITWISE_XOR, LEFT_SHIFT, RIGHT_SHIFT, UNSIGNED_RIGHT_SHIFT,
         UNKNOWN
     };
 
+    // What the tree-walking Interpreter has learned about the operands at this site. A node that
+    // has only seen numbers is quickened into the fast path for its operator, as if it had been
+    // replaced by an AddDouble node; the first operand that is not a number deoptimizes it to the
+    // generic path for good.
+    enum class Specialization : uint8_t {
+        UNINITIALIZED,
+        GENERIC,
+        ADD_DOUBLE, SUBTRACT_DOUBLE, MULTIPLY_DOUBLE, DIVIDE_DOUBLE, MODULO_DOUBLE,
+        EQUAL_DOUBLE, NOT_EQUAL_DOUBLE,
+        LESS_DOUBLE, LESS_EQUAL_DOUBLE, GREATER_DOUBLE, GREATER_EQUAL_DOUBLE
+    };
+
     BinaryExpression(unique_ptr<Expression> left, Operator op, unique_ptr<Expression> right);
 
-    std::shared_ptr<Value> accept(Visitor &visitor) override;
+    Value accept(Visitor &visitor) override;
 
     [[nodiscard]] Expression *getLeft() const;
 
@@ -87,9 +122,16 @@ public:
 
     [[nodiscard]] Expression *getRight() const;
 
+    [[nodiscard]] Specialization getSpecialization() const;
+
+    void specialize(Specialization specialization);
+
+    friend class ConstantFolder;
+
 private:
     unique_ptr<Expression> left_;
     Operator op_;
+    Specialization specialization_ = Specialization::UNINITIALIZED;
     unique_ptr<Expression> right_;
 };
 
@@ -98,17 +140,20 @@ class UnaryExpression : public Expression {
 public:
     enum class Operator {
         Negate, // -
-        Not // !
+        Not, // !
+        BitwiseNot // ~
     };
 
     UnaryExpression(Operator op, unique_ptr<Expression> right);
 
-    std::shared_ptr<Value> accept(Visitor &visitor) override;
+    Value accept(Visitor &visitor) override;
 
     [[nodiscard]] Operator getOperator() const;
 
     [[nodiscard]] Expression *getRight() const;
 
+    friend class ConstantFolder;
+
 private:
     Operator op_;
     unique_ptr<Expression> right_;
@@ -117,20 +162,31 @@ private:
 // Assignment expressions
 class AssignmentExpression : public Expression {
 public:
-    AssignmentExpression(string name, unique_ptr<Expression> value, TokenType op);
+    AssignmentExpression(Symbol name, unique_ptr<Expression> value, TokenType op);
 
-    std::shared_ptr<Value> accept(Visitor &visitor) override;
+    Value accept(Visitor &visitor) override;
 
-    [[nodiscard]] const string &getName() const;
+    [[nodiscard]] Symbol getName() const;
 
     [[nodiscard]] Expression *getValue() const;
 
     [[nodiscard]] TokenType getOperator() const;
 
+    // Set by the Resolver: scopes to walk up and the slot in that scope. Unresolved names keep depth -1
+    void resolve(int depth, int slot);
+
+    [[nodiscard]] int getDepth() const;
+
+    [[nodiscard]] int getSlot() const;
+
+    friend class ConstantFolder;
+
 private:
-    string name_;
+    Symbol name_;
     unique_ptr<Expression> value_;
     TokenType op_;
+    int depth_ = -1;
+    int slot_ = -1;
 };
 
 // Logical expressions
@@ -143,7 +199,7 @@ public:
 
     LogicalExpression(unique_ptr<Expression> left, Operator op, unique_ptr<Expression> right);
 
-    std::shared_ptr<Value> accept(Visitor &visitor) override;
+    Value accept(Visitor &visitor) override;
 
     [[nodiscard]] Expression *getLeft() const;
 
@@ -151,6 +207,8 @@ public:
 
     [[nodiscard]] Expression *getRight() const;
 
+    friend class ConstantFolder;
+
 private:
     unique_ptr<Expression> left_;
     Operator op_;
@@ -162,12 +220,14 @@ class FunctionCallExpression : public Expression {
 public:
     FunctionCallExpression(unique_ptr<Expression> callee, vector<unique_ptr<Expression> > arguments);
 
-    std::shared_ptr<Value> accept(Visitor &visitor) override;
+    Value accept(Visitor &visitor) override;
 
     [[nodiscard]] Expression *getCallee() const;
 
     [[nodiscard]] const vector<unique_ptr<Expression> > &getArguments() const;
 
+    friend class ConstantFolder;
+
 private:
     unique_ptr<Expression> callee_;
     vector<unique_ptr<Expression> > arguments_;
@@ -176,17 +236,23 @@ private:
 // Get expressions (object property access)
 class GetExpression : public Expression {
 public:
-    GetExpression(unique_ptr<Expression> object, string name);
+    GetExpression(unique_ptr<Expression> object, Symbol name);
 
-    std::shared_ptr<Value> accept(Visitor &visitor) override;
+    Value accept(Visitor &visitor) override;
 
     [[nodiscard]] Expression *getObject() const;
 
-    [[nodiscard]] const basic_string<char> &getName() const;
+    [[nodiscard]] Symbol getName() const;
+
+    // Inline cache for this access site
+    [[nodiscard]] InlineCache &getCache();
+
+    friend class ConstantFolder;
 
 private:
     unique_ptr<Expression> object_;
-    string name_;
+    Symbol name_;
+    InlineCache cache_;
 };
 
 // ********************
@@ -201,10 +267,12 @@ class ExpressionStatement : public Statement {
 public:
     explicit ExpressionStatement(unique_ptr<Expression> expression);
 
-    std::shared_ptr<Value> accept(Visitor &visitor) override;
+    Value accept(Visitor &visitor) override;
 
     [[nodiscard]] Expression *getExpression() const;
 
+    friend class ConstantFolder;
+
 private:
     unique_ptr<Expression> expression_;
 };
@@ -212,11 +280,11 @@ private:
 // Variable declarations
 class VariableDeclaration : public Statement {
 public:
-    VariableDeclaration(string name, string typeName, unique_ptr<Expression> initializer);
+    VariableDeclaration(Symbol name, string typeName, unique_ptr<Expression> initializer);
 
-    std::shared_ptr<Value> accept(Visitor &visitor) override;
+    Value accept(Visitor &visitor) override;
 
-    [[nodiscard]] const string &getName() const;
+    [[nodiscard]] Symbol getName() const;
 
     [[nodiscard]] const string &getTypeName() const;
 
@@ -227,10 +295,18 @@ public:
         return initializer_ != nullptr;
     }
 
+    // Slot assigned by the Resolver in the declaring scope, -1 if unresolved
+    void setSlot(int slot);
+
+    [[nodiscard]] int getSlot() const;
+
+    friend class ConstantFolder;
+
 private:
-    string name_;
+    Symbol name_;
     string typeName_;
     unique_ptr<Expression> initializer_;
+    int slot_ = -1;
 };
 
 // Block statements
@@ -238,10 +314,12 @@ class BlockStatement : public Statement {
 public:
     explicit BlockStatement(vector<unique_ptr<Statement> > statements);
 
-    std::shared_ptr<Value> accept(Visitor &visitor) override;
+    Value accept(Visitor &visitor) override;
 
     [[nodiscard]] const vector<unique_ptr<Statement> > &getStatements() const;
 
+    friend class ConstantFolder;
+
 private:
     vector<unique_ptr<Statement> > statements_;
 };
@@ -251,7 +329,7 @@ class IfStatement : public Statement {
 public:
     IfStatement(unique_ptr<Expression> condition, unique_ptr<Statement> thenBranch, unique_ptr<Statement> elseBranch);
 
-    std::shared_ptr<Value> accept(Visitor &visitor) override;
+    Value accept(Visitor &visitor) override;
 
     [[nodiscard]] Expression *getCondition() const;
 
@@ -259,6 +337,8 @@ public:
 
     [[nodiscard]] Statement *getElseBranch() const;
 
+    friend class ConstantFolder;
+
 private:
     unique_ptr<Expression> condition_;
     unique_ptr<Statement> thenBranch_;
@@ -270,12 +350,14 @@ class WhileStatement final : public Statement {
 public:
     WhileStatement(unique_ptr<Expression> condition, unique_ptr<Statement> body);
 
-    std::shared_ptr<Value> accept(Visitor &visitor) override;
+    Value accept(Visitor &visitor) override;
 
     [[nodiscard]] Expression *getCondition() const;
 
     [[nodiscard]] auto getBody() const -> Statement *;
 
+    friend class ConstantFolder;
+
 private:
     unique_ptr<Expression> condition_;
     unique_ptr<Statement> body_;
@@ -286,10 +368,12 @@ class ReturnStatement : public Statement {
 public:
     explicit ReturnStatement(unique_ptr<Expression> value);
 
-    std::shared_ptr<Value> accept(Visitor &visitor) override;
+    Value accept(Visitor &visitor) override;
 
     [[nodiscard]] Expression *getValue() const;
 
+    friend class ConstantFolder;
+
 private:
     unique_ptr<Expression> value_;
 };
@@ -298,16 +382,16 @@ private:
 class FunctionDeclaration final : public Statement {
 public:
     struct Parameter {
-        string name;
+        Symbol name;
         string typeName;
     };
 
-    FunctionDeclaration(string name, vector<Parameter> parameters, string returnTypeName,
+    FunctionDeclaration(Symbol name, vector<Parameter> parameters, string returnTypeName,
                         unique_ptr<BlockStatement> body);
 
-    std::shared_ptr<Value> accept(Visitor &visitor) override;
+    Value accept(Visitor &visitor) override;
 
-    [[nodiscard]] const string &getName() const;
+    [[nodiscard]] Symbol getName() const;
 
     [[nodiscard]] const vector<Parameter> &getParameters() const;
 
@@ -316,7 +400,7 @@ public:
     [[nodiscard]] BlockStatement *getBody() const;
 
 private:
-    string name_;
+    Symbol name_;
     vector<Parameter> parameters_;
     string returnTypeName_;
     unique_ptr<BlockStatement> body_;
@@ -0,0 +1,40 @@
+#include "Arena.h"
+
+#include <cstdint>
+
+thread_local Arena *Arena::active_ = nullptr;
+
+void *Arena::allocate(const size_t size, const size_t alignment) {
+    auto address = reinterpret_cast<uintptr_t>(cursor_);
+    uintptr_t aligned = (address + alignment - 1) & ~(alignment - 1);
+
+    if (cursor_ == nullptr || aligned + size > reinterpret_cast<uintptr_t>(end_)) {
+        // Oversized requests get a block of their own so the regular block size stays small
+        const size_t capacity = max(blockSize_, size + alignment);
+        blocks_.push_back(make_unique_for_overwrite<byte[]>(capacity));
+        cursor_ = blocks_.back().get();
+        end_ = cursor_ + capacity;
+        address = reinterpret_cast<uintptr_t>(cursor_);
+        aligned = (address + alignment - 1) & ~(alignment - 1);
+    }
+
+    cursor_ = reinterpret_cast<byte *>(aligned + size);
+    bytesUsed_ += aligned + size - address;
+    return reinterpret_cast<void *>(aligned);
+}
+
+Arena &Arena::current() {
+    if (active_) {
+        return *active_;
+    }
+    static Arena fallback;
+    return fallback;
+}
+
+Arena::Scope::Scope(Arena &arena) : previous_(active_) {
+    active_ = &arena;
+}
+
+Arena::Scope::~Scope() {
+    active_ = previous_;
+}
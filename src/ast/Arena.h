@@ -0,0 +1,57 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+using namespace std;
+
+// Bump allocator. Memory is handed out from large blocks and only released, all at once,
+// when the Arena is destroyed. Objects placed in it must be destroyed before that.
+class Arena {
+public:
+    explicit Arena(size_t blockSize = 64 * 1024) : blockSize_(blockSize) {
+    }
+
+    Arena(const Arena &) = delete;
+
+    Arena &operator=(const Arena &) = delete;
+
+    void *allocate(size_t size, size_t alignment = alignof(max_align_t));
+
+    // Total bytes handed out, including alignment padding
+    [[nodiscard]] size_t bytesUsed() const {
+        return bytesUsed_;
+    }
+
+    // The arena ASTNode allocations on this thread go to. Outside of any Scope this is a
+    // process-wide fallback arena that is never freed.
+    static Arena &current();
+
+    // Routes this thread's ASTNode allocations to an arena for the lifetime of the Scope
+    class Scope {
+    public:
+        explicit Scope(Arena &arena);
+
+        ~Scope();
+
+        Scope(const Scope &) = delete;
+
+        Scope &operator=(const Scope &) = delete;
+
+    private:
+        Arena *previous_;
+    };
+
+private:
+    size_t blockSize_;
+    vector<unique_ptr<byte[]> > blocks_;
+    byte *cursor_ = nullptr;
+    byte *end_ = nullptr;
+    size_t bytesUsed_ = 0;
+
+    static thread_local Arena *active_;
+};
+
+#endif // ARENA_H
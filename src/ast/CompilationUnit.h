@@ -0,0 +1,29 @@
+#ifndef COMPILATIONUNIT_H
+#define COMPILATIONUNIT_H
+
+#include <memory>
+#include <vector>
+
+#include "AST.h"
+#include "Arena.h"
+#include "../parser/Diagnostic.h"
+
+// A parsed program together with the arena its nodes were allocated from and the problems
+// found while parsing it. The arena is declared first so the nodes are destroyed before their
+// memory is released in one shot.
+struct CompilationUnit {
+    Arena arena;
+    vector<unique_ptr<Statement> > statements;
+    vector<Diagnostic> diagnostics; // In source order
+
+    [[nodiscard]] bool hasErrors() const {
+        for (const Diagnostic &diagnostic: diagnostics) {
+            if (diagnostic.severity == Diagnostic::Severity::ERROR) {
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+#endif // COMPILATIONUNIT_H
@@ -0,0 +1,138 @@
+#include "FlatAST.h"
+
+#include "AST.h"
+
+FlatProgram Flattener::flatten(const vector<unique_ptr<Statement> > &statements) {
+    program_ = FlatProgram();
+    for (const auto &statement: statements) {
+        program_.statements.push_back(flatten(statement.get()));
+    }
+    return move(program_);
+}
+
+Value Flattener::visitLiteralExpression(LiteralExpression *expression) {
+    program_.literals.push_back(expression->getValue());
+    add(FlatKind::LITERAL, 0, static_cast<uint32_t>(program_.literals.size() - 1));
+    return {};
+}
+
+Value Flattener::visitIdentifierExpression(IdentifierExpression *expression) {
+    add(FlatKind::IDENTIFIER, 0, addName(expression->getName()), depthOf(expression->getDepth()),
+        static_cast<uint32_t>(expression->getSlot()));
+    return {};
+}
+
+Value Flattener::visitBinaryExpression(BinaryExpression *expression) {
+    const uint32_t left = flatten(expression->getLeft());
+    const uint32_t right = flatten(expression->getRight());
+    add(FlatKind::BINARY, static_cast<uint8_t>(expression->getOperator()), left, right);
+    return {};
+}
+
+Value Flattener::visitUnaryExpression(UnaryExpression *expression) {
+    const uint32_t right = flatten(expression->getRight());
+    add(FlatKind::UNARY, static_cast<uint8_t>(expression->getOperator()), right);
+    return {};
+}
+
+Value Flattener::visitAssignmentExpression(AssignmentExpression *expression) {
+    const uint32_t value = flatten(expression->getValue());
+    add(FlatKind::ASSIGNMENT, 0, addName(expression->getName()), value, depthOf(expression->getDepth()),
+        static_cast<uint32_t>(expression->getSlot()));
+    return {};
+}
+
+Value Flattener::visitLogicalExpression(LogicalExpression *expression) {
+    const uint32_t left = flatten(expression->getLeft());
+    const uint32_t right = flatten(expression->getRight());
+    add(FlatKind::LOGICAL, static_cast<uint8_t>(expression->getOperator()), left, right);
+    return {};
+}
+
+Value Flattener::visitFunctionCallExpression(FunctionCallExpression *expression) {
+    const uint32_t callee = flatten(expression->getCallee());
+    vector<uint32_t> arguments;
+    for (const auto &argument: expression->getArguments()) {
+        arguments.push_back(flatten(argument.get()));
+    }
+    const auto first = static_cast<uint32_t>(program_.lists.size());
+    program_.lists.insert(program_.lists.end(), arguments.begin(), arguments.end());
+    add(FlatKind::CALL, 0, callee, first, static_cast<uint32_t>(arguments.size()));
+    return {};
+}
+
+Value Flattener::visitGetExpression(GetExpression *expression) {
+    const uint32_t object = flatten(expression->getObject());
+    program_.caches.emplace_back();
+    add(FlatKind::GET, 0, object, addName(expression->getName()),
+        static_cast<uint32_t>(program_.caches.size() - 1));
+    return {};
+}
+
+void Flattener::visitExpressionStatement(ExpressionStatement *statement) {
+    add(FlatKind::EXPRESSION_STATEMENT, 0, flatten(statement->getExpression()));
+}
+
+void Flattener::visitVariableDeclaration(VariableDeclaration *statement) {
+    const uint32_t initializer = statement->hasInitializer()
+                                     ? flatten(statement->getInitializer())
+                                     : FlatProgram::NONE;
+    add(FlatKind::VARIABLE_DECLARATION, statement->getTypeName() == "const", addName(statement->getName()),
+        initializer, static_cast<uint32_t>(statement->getSlot()));
+}
+
+void Flattener::visitBlockStatement(BlockStatement *statement) {
+    vector<uint32_t> statements;
+    for (const auto &inner: statement->getStatements()) {
+        if (inner) {
+            statements.push_back(flatten(inner.get()));
+        }
+    }
+    const auto first = static_cast<uint32_t>(program_.lists.size());
+    program_.lists.insert(program_.lists.end(), statements.begin(), statements.end());
+    add(FlatKind::BLOCK, 0, first, static_cast<uint32_t>(statements.size()));
+}
+
+void Flattener::visitIfStatement(IfStatement *statement) {
+    const uint32_t condition = flatten(statement->getCondition());
+    const uint32_t thenBranch = flatten(statement->getThenBranch());
+    const uint32_t elseBranch = statement->getElseBranch()
+                                    ? flatten(statement->getElseBranch())
+                                    : FlatProgram::NONE;
+    add(FlatKind::IF, 0, condition, thenBranch, elseBranch);
+}
+
+void Flattener::visitWhileStatement(WhileStatement *statement) {
+    const uint32_t condition = flatten(statement->getCondition());
+    const uint32_t body = flatten(statement->getBody());
+    add(FlatKind::WHILE, 0, condition, body);
+}
+
+void Flattener::visitReturnStatement(ReturnStatement *statement) {
+    add(FlatKind::RETURN, 0);
+}
+
+void Flattener::visitFunctionDeclaration(FunctionDeclaration *statement) {
+    add(FlatKind::FUNCTION_DECLARATION, 0);
+}
+
+uint32_t Flattener::flatten(ASTNode *node) {
+    node->accept(*this);
+    return lastIndex_;
+}
+
+uint32_t Flattener::add(const FlatKind kind, const uint8_t op, const uint32_t a, const uint32_t b, const uint32_t c,
+                        const uint32_t d) {
+    program_.nodes.push_back({kind, op, a, b, c, d});
+    lastIndex_ = static_cast<uint32_t>(program_.nodes.size() - 1);
+    return lastIndex_;
+}
+
+uint32_t Flattener::addName(const Symbol name) {
+    program_.names.push_back(name);
+    return static_cast<uint32_t>(program_.names.size() - 1);
+}
+
+uint32_t Flattener::depthOf(const int depth) {
+    return depth >= 0 ? static_cast<uint32_t>(depth) : FlatProgram::NONE;
+}
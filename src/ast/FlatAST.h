@@ -0,0 +1,104 @@
+#ifndef FLATAST_H
+#define FLATAST_H
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "../visitor/Visitor.h"
+#include "../../include/Symbol.h"
+#include "object/InlineCache.h"
+#include "value/Value.h"
+
+// Flattened form of a resolved program: every node sits in one contiguous vector and refers
+// to its children by 32-bit index, so walking it touches a few dense arrays instead of
+// chasing heap pointers and vtables.
+enum class FlatKind : uint8_t {
+    LITERAL, // a: literal index
+    IDENTIFIER, // a: name index, b: depth, c: slot
+    BINARY, // op: BinaryExpression::Operator, a: left, b: right
+    UNARY, // op: UnaryExpression::Operator, a: operand
+    ASSIGNMENT, // a: name index, b: value, c: depth, d: slot
+    LOGICAL, // op: LogicalExpression::Operator, a: left, b: right
+    CALL, // a: callee, b: first argument in lists, c: argument count
+    GET, // a: object, b: name index, c: cache index
+    EXPRESSION_STATEMENT, // a: expression
+    VARIABLE_DECLARATION, // op: is const, a: name index, b: initializer or NONE, c: slot
+    BLOCK, // a: first statement in lists, b: statement count
+    IF, // a: condition, b: then branch, c: else branch or NONE
+    WHILE, // a: condition, b: body
+    RETURN,
+    FUNCTION_DECLARATION,
+};
+
+struct FlatNode {
+    FlatKind kind;
+    uint8_t op;
+    uint32_t a, b, c, d;
+};
+
+struct FlatProgram {
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    vector<FlatNode> nodes;
+    vector<uint32_t> lists; // Child index runs for blocks and call arguments
+    vector<Value> literals;
+    vector<Symbol> names;
+    vector<InlineCache> caches; // One per GET node
+    vector<uint32_t> statements; // Top-level statements, in order
+};
+
+// Builds a FlatProgram from a parsed program. Run the Resolver first so identifiers carry
+// their (depth, slot); unresolved ones are stored with depth NONE and looked up by name.
+class Flattener : public Visitor {
+public:
+    FlatProgram flatten(const vector<unique_ptr<Statement> > &statements);
+
+    // Visitor methods for expressions
+    Value visitLiteralExpression(LiteralExpression *expression) override;
+
+    Value visitIdentifierExpression(IdentifierExpression *expression) override;
+
+    Value visitBinaryExpression(BinaryExpression *expression) override;
+
+    Value visitUnaryExpression(UnaryExpression *expression) override;
+
+    Value visitAssignmentExpression(AssignmentExpression *expression) override;
+
+    Value visitLogicalExpression(LogicalExpression *expression) override;
+
+    Value visitFunctionCallExpression(FunctionCallExpression *expression) override;
+
+    Value visitGetExpression(GetExpression *expression) override;
+
+    // Visitor methods for statements
+    void visitExpressionStatement(ExpressionStatement *statement) override;
+
+    void visitVariableDeclaration(VariableDeclaration *statement) override;
+
+    void visitBlockStatement(BlockStatement *statement) override;
+
+    void visitIfStatement(IfStatement *statement) override;
+
+    void visitWhileStatement(WhileStatement *statement) override;
+
+    void visitReturnStatement(ReturnStatement *statement) override;
+
+    void visitFunctionDeclaration(FunctionDeclaration *statement) override;
+
+private:
+    FlatProgram program_;
+
+    // Index of the node produced by the most recent visit
+    uint32_t lastIndex_ = FlatProgram::NONE;
+
+    uint32_t flatten(ASTNode *node);
+
+    uint32_t add(FlatKind kind, uint8_t op, uint32_t a = 0, uint32_t b = 0, uint32_t c = 0, uint32_t d = 0);
+
+    uint32_t addName(Symbol name);
+
+    static uint32_t depthOf(int depth);
+};
+
+#endif // FLATAST_H
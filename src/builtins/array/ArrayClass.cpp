@@ -7,20 +7,26 @@
 
 ArrayClass::ArrayClass() {
     this->name = "Array";
-    this->methods["push"] = std::make_shared<PushMethod>();
+    // Inline caches hold on to the methods they found, so like the class they must never move or die
+    this->methods[Symbol::intern("push")] = Heap::current().allocatePermanent<PushMethod>();
     // Add static methods
-    this->staticMethods["create"] = std::make_shared<CreateArrayMethod>();
+    this->staticMethods[Symbol::intern("create")] = Heap::current().allocatePermanent<CreateArrayMethod>();
 }
 
-void ArrayClass::invokeMethod(const std::string &methodName, Object *target,
-                              const std::vector<shared_ptr<Value> > &arguments) {
-    if (methods.find(methodName) != methods.end()) {
-        methods[methodName]->call(arguments);
+ArrayClass *ArrayClass::shared() {
+    static thread_local ArrayClass *arrayClass = Heap::current().allocatePermanent<ArrayClass>();
+    return arrayClass;
+}
+
+void ArrayClass::invokeMethod(const Symbol methodName, Object *target, const std::vector<Value> &arguments) {
+    const auto method = methods.find(methodName);
+    if (method != methods.end()) {
+        method->second->call(arguments);
     } else {
-        throw std::runtime_error("Method not found: " + methodName);
+        throw std::runtime_error("Method not found: " + methodName.str());
     }
 }
 
-shared_ptr<Value> ArrayClass::instantiate(const std::vector<shared_ptr<Value> > &arguments) {
-    return make_unique<Value>(std::make_shared<ArrayObject>());
+Value ArrayClass::instantiate(const std::vector<Value> &arguments) {
+    return Value(Heap::current().allocate<ArrayObject>());
 }
@@ -8,10 +8,12 @@ class ArrayClass : public Class {
 public:
     ArrayClass();
 
-    std::shared_ptr<Value> instantiate(const std::vector<std::shared_ptr<Value> > &arguments) override;
+    // The calling thread's Array class, a permanent object of its heap shared by every engine
+    static ArrayClass *shared();
 
-    void invokeMethod(const std::string &methodName, Object *target,
-                      const std::vector<std::shared_ptr<Value> > &arguments) override;
+    Value instantiate(const std::vector<Value> &arguments) override;
+
+    void invokeMethod(Symbol methodName, Object *target, const std::vector<Value> &arguments) override;
 };
 
 #endif // ARRAYCLASS_H
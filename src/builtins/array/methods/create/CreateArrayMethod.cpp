@@ -5,6 +5,6 @@
 #include "CreateArrayMethod.h"
 #include "builtins/array/object/ArrayObject.h"
 
-std::shared_ptr<Value> CreateArrayMethod::call(const std::vector<std::shared_ptr<Value> > &args) {
-    return std::make_unique<Value>(std::make_shared<ArrayObject>());
+Value CreateArrayMethod::call(const std::vector<Value> &args) {
+    return Value(Heap::current().allocate<ArrayObject>());
 }
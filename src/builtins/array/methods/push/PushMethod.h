@@ -8,7 +8,7 @@ class ArrayObject;
 
 class PushMethod final : public Function {
 public:
-    std::shared_ptr<Value> call(const std::vector<std::shared_ptr<Value> > &args) override;
+    Value call(const std::vector<Value> &args) override;
 };
 
 #endif // PUSHMETHOD_H
@@ -6,5 +6,13 @@
 #include "builtins/array/ArrayClass.h"
 
 ArrayObject::ArrayObject() {
-    this->classType = std::make_shared<ArrayClass>();
+    // Every array shares one class, so inline caches see a single receiver class
+    this->classType = ArrayClass::shared();
+}
+
+void ArrayObject::trace(Heap &heap) {
+    Object::trace(heap);
+    for (Value &value: values) {
+        heap.mark(value);
+    }
 }
@@ -10,13 +10,16 @@ class ArrayClass;
 
 class ArrayObject : public Object {
 public:
-    std::vector<std::shared_ptr<Value> > values;
+    std::vector<Value> values;
 
     ArrayObject();
 
-    void push(const std::shared_ptr<Value> &value) {
+    void push(const Value &value) {
+        Heap::writeBarrier(this, value);
         values.push_back(value);
     }
+
+    void trace(Heap &heap) override;
 };
 
 #endif //ARRAYOBJECT_H
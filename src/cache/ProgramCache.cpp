@@ -0,0 +1,693 @@
+#include "ProgramCache.h"
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <type_traits>
+
+#ifndef _WIN32
+#include <unistd.h>
+#else
+#include <process.h>
+#endif
+
+#include "lexer/SourceFile.h"
+
+using namespace std;
+
+namespace {
+    constexpr uint32_t MAGIC = 0x31435359; // "YSC1" read little-endian; other byte orders never match
+
+    // Bump when the layout below changes. The highest OpCode and FlatKind are folded in as well,
+    // so adding an instruction or a node kind invalidates old entries without a manual bump.
+    constexpr uint32_t FORMAT_VERSION = 3;
+    constexpr uint32_t LAYOUT = FORMAT_VERSION << 16 | static_cast<uint32_t>(OpCode::HALT) << 8 |
+                                static_cast<uint32_t>(FlatKind::FUNCTION_DECLARATION);
+
+    // Bits of Header::options, one per setting that changes how a program is lowered
+    constexpr uint64_t FOLD_CONSTANTS = 1;
+
+    // Header shared by every entry. The source hash and size guard against hash collisions
+    // between cached scripts and against entries copied between cache directories; the payload
+    // hash catches entries that were damaged after they were written.
+    struct Header {
+        uint32_t magic;
+        uint32_t layout;
+        uint64_t options;
+        uint64_t sourceHash;
+        uint64_t sourceSize;
+        uint64_t payloadHash;
+    };
+
+    // Appends fixed-size values, length-prefixed strings and arrays to a byte string
+    class Writer {
+    public:
+        string bytes;
+
+        template<typename T>
+        void write(const T &value) {
+            static_assert(is_trivially_copyable_v<T>);
+            bytes.append(reinterpret_cast<const char *>(&value), sizeof(T));
+        }
+
+        void writeString(const string_view text) {
+            write(static_cast<uint32_t>(text.size()));
+            bytes += text;
+        }
+
+        template<typename T>
+        void writeArray(const vector<T> &values) {
+            static_assert(is_trivially_copyable_v<T>);
+            write(static_cast<uint32_t>(values.size()));
+            bytes.append(reinterpret_cast<const char *>(values.data()), values.size() * sizeof(T));
+        }
+
+        void writeNames(const vector<Symbol> &names) {
+            write(static_cast<uint32_t>(names.size()));
+            for (const Symbol name: names) {
+                writeString(name.str());
+            }
+        }
+
+        // Only literal values reach the constant pools
+        void writeValues(const vector<Value> &values) {
+            write(static_cast<uint32_t>(values.size()));
+            for (const Value &value: values) {
+                if (value.isDouble()) {
+                    write(TokenType::DOUBLE_LITERAL);
+                    write(value.asDouble());
+                } else if (value.isBool()) {
+                    write(TokenType::BOOLEAN_LITERAL);
+                    write(value.asBool());
+                } else if (value.isString()) {
+                    write(TokenType::STRING_LITERAL);
+                    writeString(value.asString());
+                } else if (value.isNull()) {
+                    write(TokenType::NULL_LITERAL);
+                } else {
+                    throw runtime_error("Cannot cache a non-literal constant");
+                }
+            }
+        }
+    };
+
+    // Reads back what Writer wrote, straight out of the mapped file. Every read is bounds
+    // checked, so a truncated or corrupt entry throws instead of reading past the mapping.
+    class Reader {
+    public:
+        explicit Reader(const string_view bytes) : bytes_(bytes) {
+        }
+
+        template<typename T>
+        T read() {
+            static_assert(is_trivially_copyable_v<T>);
+            T value;
+            memcpy(&value, take(sizeof(T)), sizeof(T));
+            return value;
+        }
+
+        string_view readString() {
+            const uint32_t size = read<uint32_t>();
+            return {take(size), size};
+        }
+
+        // Bounds checked before anything is allocated, so a corrupt count cannot ask for gigabytes
+        template<typename T>
+        void readArray(vector<T> &values) {
+            const uint32_t count = read<uint32_t>();
+            const size_t bytes = static_cast<size_t>(count) * sizeof(T);
+            const char *data = take(bytes);
+            values.resize(count);
+            if (bytes > 0) {
+                memcpy(values.data(), data, bytes);
+            }
+        }
+
+        void readNames(vector<Symbol> &names) {
+            const uint32_t count = readCount(sizeof(uint32_t));
+            names.reserve(count);
+            for (uint32_t i = 0; i < count; i++) {
+                names.push_back(Symbol::intern(readString()));
+            }
+        }
+
+        void readValues(vector<Value> &values) {
+            const uint32_t count = readCount(sizeof(TokenType));
+            values.reserve(count);
+            for (uint32_t i = 0; i < count; i++) {
+                switch (read<TokenType>()) {
+                    case TokenType::DOUBLE_LITERAL:
+                        values.emplace_back(read<double>());
+                        break;
+                    case TokenType::BOOLEAN_LITERAL:
+                        values.emplace_back(read<bool>());
+                        break;
+                    case TokenType::STRING_LITERAL:
+                        values.emplace_back(string(readString()));
+                        break;
+                    case TokenType::NULL_LITERAL:
+                        values.emplace_back();
+                        break;
+                    default:
+                        throw runtime_error("Corrupt cache entry");
+                }
+            }
+        }
+
+        [[nodiscard]] bool atEnd() const {
+            return position_ == bytes_.size();
+        }
+
+    private:
+        string_view bytes_;
+        size_t position_ = 0;
+
+        // Reads the length of a list whose entries take at least `minimumSize` bytes each
+        uint32_t readCount(const size_t minimumSize) {
+            const uint32_t count = read<uint32_t>();
+            if (count > (bytes_.size() - position_) / minimumSize) {
+                throw runtime_error("Corrupt cache entry");
+            }
+            return count;
+        }
+
+        const char *take(const size_t size) {
+            if (size > bytes_.size() - position_) {
+                throw runtime_error("Corrupt cache entry");
+            }
+            const char *data = bytes_.data() + position_;
+            position_ += size;
+            return data;
+        }
+    };
+
+    [[noreturn]] void corrupt() {
+        throw runtime_error("Corrupt cache entry");
+    }
+
+    // Values an instruction needs on the stack, and the change it makes to the stack's depth
+    void stackEffect(const OpCode op, const uint16_t operand, size_t &needs, ptrdiff_t &change) {
+        switch (op) {
+            case OpCode::CONSTANT:
+            case OpCode::NIL:
+            case OpCode::TRUE:
+            case OpCode::FALSE:
+            case OpCode::GET_LOCAL:
+            case OpCode::GET_GLOBAL:
+                needs = 0;
+                change = 1;
+                break;
+            case OpCode::POP:
+            case OpCode::DEFINE_LOCAL:
+                needs = 1;
+                change = -1;
+                break;
+            case OpCode::SET_LOCAL:
+            case OpCode::GET_PROPERTY:
+            case OpCode::NEGATE:
+            case OpCode::NOT:
+            case OpCode::BITWISE_NOT:
+            case OpCode::TRUTHY:
+            case OpCode::JUMP_IF_FALSE:
+                needs = 1;
+                change = 0;
+                break;
+            case OpCode::CALL:
+                needs = static_cast<size_t>(operand) + 1;
+                change = -static_cast<ptrdiff_t>(operand);
+                break;
+            case OpCode::SET_GLOBAL:
+            case OpCode::JUMP:
+            case OpCode::LOOP:
+            case OpCode::PRINT_RESULT:
+            case OpCode::HALT:
+                needs = 0;
+                change = 0;
+                break;
+            default: // The binary operators
+                needs = 2;
+                change = -1;
+                break;
+        }
+    }
+
+    // The checksum only catches accidental damage, so the loaded program is checked as well: every
+    // operand the VM uses as an index must be in range, every jump must land on an instruction and
+    // no path may pop more than it pushed, since the VM trusts its bytecode and does not bounds
+    // check while it runs.
+    void checkOperands(const Chunk &chunk) {
+        // Operands are 16 bits wide, so no valid program needs more slots or caches than this
+        if (chunk.slotCount > UINT16_MAX + 1 || chunk.cacheCount > UINT16_MAX + 1) {
+            corrupt();
+        }
+        const vector<uint8_t> &code = chunk.code;
+        vector<bool> starts(code.size() + 1, false);
+        vector<size_t> targets;
+        OpCode last = OpCode::HALT;
+        size_t offset = 0;
+        while (offset < code.size()) {
+            const auto op = static_cast<OpCode>(code[offset]);
+            if (op > OpCode::HALT || instructionLength(op) > code.size() - offset) {
+                corrupt();
+            }
+            starts[offset] = true;
+            const size_t next = offset + instructionLength(op);
+            const uint16_t operand = instructionLength(op) > 1 ? chunk.readShort(offset + 1) : 0;
+            switch (op) {
+                case OpCode::CONSTANT:
+                    if (operand >= chunk.constants.size()) {
+                        corrupt();
+                    }
+                    break;
+                case OpCode::DEFINE_LOCAL:
+                case OpCode::GET_LOCAL:
+                case OpCode::SET_LOCAL:
+                    if (operand >= chunk.slotCount) {
+                        corrupt();
+                    }
+                    break;
+                case OpCode::GET_GLOBAL:
+                case OpCode::SET_GLOBAL:
+                    if (operand >= chunk.names.size()) {
+                        corrupt();
+                    }
+                    break;
+                case OpCode::GET_PROPERTY:
+                    if (operand >= chunk.names.size() || chunk.readShort(offset + 3) >= chunk.cacheCount) {
+                        corrupt();
+                    }
+                    break;
+                case OpCode::JUMP:
+                case OpCode::JUMP_IF_FALSE:
+                    targets.push_back(next + operand);
+                    break;
+                case OpCode::LOOP:
+                    if (operand > next) {
+                        corrupt();
+                    }
+                    targets.push_back(next - operand);
+                    break;
+                default:
+                    break;
+            }
+            last = op;
+            offset = next;
+        }
+        // Running off the end of the code is as bad as jumping past it
+        if (code.empty() || last != OpCode::HALT) {
+            corrupt();
+        }
+        for (const size_t target: targets) {
+            if (target >= code.size() || !starts[target]) {
+                corrupt();
+            }
+        }
+
+        // The Compiler leaves the stack equally deep on every path into an instruction, so one
+        // depth per instruction is enough; a path that disagrees with it is corrupt
+        constexpr size_t UNVISITED = SIZE_MAX;
+        vector<size_t> depths(code.size(), UNVISITED);
+        vector<size_t> pending{0};
+        depths[0] = 0;
+        const auto reach = [&](const size_t target, const size_t depth) {
+            if (depths[target] == UNVISITED) {
+                depths[target] = depth;
+                pending.push_back(target);
+            } else if (depths[target] != depth) {
+                corrupt();
+            }
+        };
+        while (!pending.empty()) {
+            const size_t at = pending.back();
+            pending.pop_back();
+            const auto op = static_cast<OpCode>(code[at]);
+            const size_t next = at + instructionLength(op);
+            const uint16_t operand = instructionLength(op) > 1 ? chunk.readShort(at + 1) : 0;
+            size_t needs;
+            ptrdiff_t change;
+            stackEffect(op, operand, needs, change);
+            if (depths[at] < needs) {
+                corrupt();
+            }
+            const size_t depth = depths[at] + change;
+            switch (op) {
+                case OpCode::HALT:
+                    break;
+                case OpCode::JUMP:
+                    reach(next + operand, depth);
+                    break;
+                case OpCode::LOOP:
+                    reach(next - operand, depth);
+                    break;
+                case OpCode::JUMP_IF_FALSE:
+                    reach(next + operand, depth);
+                    reach(next, depth);
+                    break;
+                default:
+                    reach(next, depth);
+                    break;
+            }
+        }
+    }
+
+    // The same for a flat program. The Flattener adds every child before its parent, so children
+    // must have smaller indices; that also rules out cycles. Slots are replayed the way the
+    // Resolver assigned them, so a resolved variable always refers to one its scope has declared.
+    class FlatChecker {
+    public:
+        explicit FlatChecker(const FlatProgram &program) : program_(program) {
+        }
+
+        void check() {
+            for (uint32_t i = 0; i < program_.nodes.size(); i++) {
+                checkNode(i);
+            }
+            scopes_.assign(1, 0); // The global scope
+            for (const uint32_t statement: program_.statements) {
+                if (statement >= program_.nodes.size()) {
+                    corrupt();
+                }
+                walk(statement);
+            }
+        }
+
+    private:
+        const FlatProgram &program_;
+        vector<uint32_t> scopes_; // Slots declared so far in each open scope, innermost last
+
+        static bool isStatement(const FlatKind kind) {
+            return kind >= FlatKind::EXPRESSION_STATEMENT;
+        }
+
+        void child(const uint32_t parent, const uint32_t index, const bool statement) const {
+            if (index >= parent || isStatement(program_.nodes[index].kind) != statement) {
+                corrupt();
+            }
+        }
+
+        void list(const uint32_t parent, const uint32_t first, const uint32_t count, const bool statements) const {
+            if (first > program_.lists.size() || count > program_.lists.size() - first) {
+                corrupt();
+            }
+            for (uint32_t i = 0; i < count; i++) {
+                child(parent, program_.lists[first + i], statements);
+            }
+        }
+
+        static void below(const uint32_t index, const size_t size) {
+            if (index >= size) {
+                corrupt();
+            }
+        }
+
+        // Checks everything that does not depend on scope
+        void checkNode(const uint32_t index) const {
+            const FlatNode &node = program_.nodes[index];
+            switch (node.kind) {
+                case FlatKind::LITERAL:
+                    below(node.a, program_.literals.size());
+                    break;
+                case FlatKind::IDENTIFIER:
+                    below(node.a, program_.names.size());
+                    break;
+                case FlatKind::BINARY:
+                case FlatKind::LOGICAL:
+                    child(index, node.a, false);
+                    child(index, node.b, false);
+                    break;
+                case FlatKind::UNARY:
+                case FlatKind::EXPRESSION_STATEMENT:
+                    child(index, node.a, false);
+                    break;
+                case FlatKind::ASSIGNMENT:
+                    below(node.a, program_.names.size());
+                    child(index, node.b, false);
+                    break;
+                case FlatKind::CALL:
+                    child(index, node.a, false);
+                    list(index, node.b, node.c, false);
+                    break;
+                case FlatKind::GET:
+                    child(index, node.a, false);
+                    below(node.b, program_.names.size());
+                    below(node.c, program_.caches.size());
+                    break;
+                case FlatKind::VARIABLE_DECLARATION:
+                    below(node.a, program_.names.size());
+                    if (node.b != FlatProgram::NONE) {
+                        child(index, node.b, false);
+                    }
+                    break;
+                case FlatKind::BLOCK:
+                    list(index, node.a, node.b, true);
+                    break;
+                case FlatKind::IF:
+                    child(index, node.a, false);
+                    child(index, node.b, true);
+                    if (node.c != FlatProgram::NONE) {
+                        child(index, node.c, true);
+                    }
+                    break;
+                case FlatKind::WHILE:
+                    child(index, node.a, false);
+                    child(index, node.b, true);
+                    break;
+                case FlatKind::RETURN:
+                case FlatKind::FUNCTION_DECLARATION:
+                    break;
+                default:
+                    corrupt();
+            }
+        }
+
+        // A resolved (depth, slot) must name a slot that is already declared when the node runs
+        void resolved(const uint32_t depth, const uint32_t slot) const {
+            if (depth != FlatProgram::NONE &&
+                (depth >= scopes_.size() || slot >= scopes_[scopes_.size() - 1 - depth])) {
+                corrupt();
+            }
+        }
+
+        // Visits the tree in the Resolver's order; structure was checked already
+        void walk(const uint32_t index) {
+            const FlatNode &node = program_.nodes[index];
+            switch (node.kind) {
+                case FlatKind::IDENTIFIER:
+                    resolved(node.b, node.c);
+                    break;
+                case FlatKind::ASSIGNMENT:
+                    walk(node.b);
+                    resolved(node.c, node.d);
+                    break;
+                case FlatKind::BINARY:
+                case FlatKind::LOGICAL:
+                    walk(node.a);
+                    walk(node.b);
+                    break;
+                case FlatKind::UNARY:
+                case FlatKind::EXPRESSION_STATEMENT:
+                case FlatKind::GET:
+                    walk(node.a);
+                    break;
+                case FlatKind::CALL:
+                    walk(node.a);
+                    for (uint32_t i = 0; i < node.c; i++) {
+                        walk(program_.lists[node.b + i]);
+                    }
+                    break;
+                case FlatKind::VARIABLE_DECLARATION:
+                    if (node.b != FlatProgram::NONE) {
+                        walk(node.b);
+                    }
+                    // Unresolved declarations are defined by name; resolved ones take the next slot
+                    if (node.c != FlatProgram::NONE) {
+                        if (node.c != scopes_.back()) {
+                            corrupt();
+                        }
+                        scopes_.back()++;
+                    }
+                    break;
+                case FlatKind::BLOCK:
+                    scopes_.push_back(0);
+                    for (uint32_t i = 0; i < node.b; i++) {
+                        walk(program_.lists[node.a + i]);
+                    }
+                    scopes_.pop_back();
+                    break;
+                case FlatKind::IF:
+                    walk(node.a);
+                    walk(node.b);
+                    if (node.c != FlatProgram::NONE) {
+                        walk(node.c);
+                    }
+                    break;
+                case FlatKind::WHILE:
+                    walk(node.a);
+                    walk(node.b);
+                    break;
+                default:
+                    break;
+            }
+        }
+    };
+
+    // Maps the entry at `path` and checks that it was written for a source of this hash and size
+    // and that its payload is intact; `parse` reads the rest. Returns false if there is no usable entry.
+    template<typename Parse>
+    bool readEntry(const string &path, const uint64_t options, const uint64_t sourceHash, const size_t sourceSize,
+                   Parse parse) {
+        if (!filesystem::exists(path)) {
+            return false;
+        }
+        try {
+            const SourceFile file(path);
+            Reader reader(file.text());
+            const auto header = reader.read<Header>();
+            if (header.magic != MAGIC || header.layout != LAYOUT || header.options != options ||
+                header.sourceHash != sourceHash ||
+                header.sourceSize != sourceSize ||
+                header.payloadHash != ProgramCache::hashSource(file.text().substr(sizeof(Header)))) {
+                return false;
+            }
+            parse(reader);
+            return reader.atEnd();
+        } catch (const runtime_error &) {
+            return false;
+        }
+    }
+
+    // Prepends the header to a finished payload
+    string withHeader(const uint64_t options, const uint64_t sourceHash, const size_t sourceSize,
+                      const string &payload) {
+        Writer writer;
+        writer.write(Header{MAGIC, LAYOUT, options, sourceHash, sourceSize, ProgramCache::hashSource(payload)});
+        return writer.bytes + payload;
+    }
+}
+
+ProgramCache::ProgramCache(string directory, const bool foldConstants) : directory_(move(directory)),
+                                                                         foldConstants_(foldConstants) {
+}
+
+uint64_t ProgramCache::hashSource(const string_view source) {
+    uint64_t hash = 0xcbf29ce484222325;
+    for (const char c: source) {
+        hash = (hash ^ static_cast<uint8_t>(c)) * 0x100000001b3;
+    }
+    return hash;
+}
+
+bool ProgramCache::load(const string_view source, Chunk &chunk) const {
+    const uint64_t hash = hashSource(source);
+    Chunk loaded;
+    const bool hit = readEntry(pathFor(hash, "vm"), options(), hash, source.size(), [&loaded](Reader &reader) {
+        loaded.slotCount = reader.read<uint64_t>();
+        loaded.cacheCount = reader.read<uint64_t>();
+        reader.readArray(loaded.code);
+        reader.readValues(loaded.constants);
+        reader.readNames(loaded.names);
+        checkOperands(loaded);
+    });
+    if (hit) {
+        chunk = move(loaded);
+    }
+    return hit;
+}
+
+bool ProgramCache::load(const string_view source, FlatProgram &program) const {
+    const uint64_t hash = hashSource(source);
+    FlatProgram loaded;
+    const bool hit = readEntry(pathFor(hash, "flat"), options(), hash, source.size(), [&loaded](Reader &reader) {
+        reader.readArray(loaded.nodes);
+        reader.readArray(loaded.lists);
+        reader.readArray(loaded.statements);
+        reader.readValues(loaded.literals);
+        reader.readNames(loaded.names);
+        // One cache per GET node, so there can't be more caches than nodes
+        const uint32_t cacheCount = reader.read<uint32_t>();
+        if (cacheCount > loaded.nodes.size()) {
+            corrupt();
+        }
+        loaded.caches.resize(cacheCount);
+        FlatChecker(loaded).check();
+    });
+    if (hit) {
+        program = move(loaded);
+    }
+    return hit;
+}
+
+void ProgramCache::store(const string_view source, const Chunk &chunk) const {
+    try {
+        const uint64_t hash = hashSource(source);
+        Writer writer;
+        writer.write(static_cast<uint64_t>(chunk.slotCount));
+        writer.write(static_cast<uint64_t>(chunk.cacheCount));
+        writer.writeArray(chunk.code);
+        writer.writeValues(chunk.constants);
+        writer.writeNames(chunk.names);
+        write(pathFor(hash, "vm"), withHeader(options(), hash, source.size(), writer.bytes));
+    } catch (const exception &error) {
+        cerr << "Could not cache the program: " << error.what() << endl;
+    }
+}
+
+void ProgramCache::store(const string_view source, const FlatProgram &program) const {
+    try {
+        const uint64_t hash = hashSource(source);
+        Writer writer;
+        writer.writeArray(program.nodes);
+        writer.writeArray(program.lists);
+        writer.writeArray(program.statements);
+        writer.writeValues(program.literals);
+        writer.writeNames(program.names);
+        writer.write(static_cast<uint32_t>(program.caches.size()));
+        write(pathFor(hash, "flat"), withHeader(options(), hash, source.size(), writer.bytes));
+    } catch (const exception &error) {
+        cerr << "Could not cache the program: " << error.what() << endl;
+    }
+}
+
+uint64_t ProgramCache::options() const {
+    return foldConstants_ ? FOLD_CONSTANTS : 0;
+}
+
+// Named <source hash>-<options>.<form>, so entries lowered with different options sit side by side
+string ProgramCache::pathFor(const uint64_t sourceHash, const string_view extension) const {
+    char name[40];
+    snprintf(name, sizeof(name), "%016llx-%llx", static_cast<unsigned long long>(sourceHash),
+             static_cast<unsigned long long>(options()));
+    return (filesystem::path(directory_) / (string(name) + "." + string(extension))).string();
+}
+
+// Writes to a temporary file first and renames it into place, so a concurrent run never maps a
+// half-written entry. Each writer gets its own temporary file; one that fails is removed again.
+void ProgramCache::write(const string &path, const string &bytes) const {
+    filesystem::create_directories(directory_);
+#ifndef _WIN32
+    const auto process = static_cast<unsigned long long>(getpid());
+#else
+    const auto process = static_cast<unsigned long long>(_getpid());
+#endif
+    char suffix[48];
+    snprintf(suffix, sizeof(suffix), ".%llu-%08x.tmp", process, random_device()());
+    const string temporary = path + suffix;
+    try {
+        {
+            ofstream out(temporary, ios::binary | ios::trunc);
+            out.write(bytes.data(), static_cast<streamsize>(bytes.size()));
+            if (!out) {
+                throw runtime_error("Could not write " + temporary);
+            }
+        }
+        filesystem::rename(temporary, path);
+    } catch (...) {
+        error_code ignored;
+        filesystem::remove(temporary, ignored);
+        throw;
+    }
+}
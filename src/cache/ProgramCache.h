@@ -0,0 +1,52 @@
+#ifndef PROGRAMCACHE_H
+#define PROGRAMCACHE_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "ast/FlatAST.h"
+#include "compiler/Chunk.h"
+
+using namespace std;
+
+// On-disk cache of lowered programs, so an unchanged script skips the Lexer, the Parser and the
+// lowering pass on its next run. Entries are named after a hash of the source text and the form
+// they hold (VM bytecode or a flat program) and of the options the program was lowered with, so
+// a run with --no-fold never picks up folded code. Entries are read back through a single file mapping.
+// A missing, stale or corrupt entry is a miss; the caller parses as usual and stores a new one.
+class ProgramCache {
+public:
+    // `foldConstants` is whether the programs stored and looked up had their constants folded
+    ProgramCache(string directory, bool foldConstants);
+
+    // 64-bit FNV-1a over the source text; stable across runs and builds
+    static uint64_t hashSource(string_view source);
+
+    // Fill `chunk` / `program` from the entry for `source`, returning false on a miss
+    bool load(string_view source, Chunk &chunk) const;
+
+    bool load(string_view source, FlatProgram &program) const;
+
+    // Write the entry for `source`. Failures are reported on cerr and otherwise ignored.
+    void store(string_view source, const Chunk &chunk) const;
+
+    void store(string_view source, const FlatProgram &program) const;
+
+    [[nodiscard]] const string &getDirectory() const {
+        return directory_;
+    }
+
+private:
+    string directory_;
+    bool foldConstants_;
+
+    // Lowering options recorded in, and required of, every entry
+    [[nodiscard]] uint64_t options() const;
+
+    [[nodiscard]] string pathFor(uint64_t sourceHash, string_view extension) const;
+
+    void write(const string &path, const string &bytes) const;
+};
+
+#endif //PROGRAMCACHE_H
@@ -4,3 +4,17 @@
 
 #include "Class.h"
 
+#include "function/Function.h"
+
+void Class::trace(Heap &heap) {
+    Object::trace(heap);
+    for (auto &[name, method]: methods) {
+        heap.mark(method);
+    }
+    for (auto &[name, method]: staticMethods) {
+        heap.mark(method);
+    }
+    for (auto &[name, property]: staticProperties) {
+        heap.mark(property);
+    }
+}
@@ -1,7 +1,7 @@
 #ifndef CLASS_H
 #define CLASS_H
 
-#include <map>
+#include <unordered_map>
 #include <string>
 #include <memory>
 #include <vector>
@@ -13,14 +13,15 @@ class Function; // Forward declaration
 class Class : public Object {
 public:
     std::string name;
-    std::map<std::string, std::shared_ptr<Function> > methods;
-    std::map<std::string, std::shared_ptr<Function> > staticMethods;
-    std::map<std::string, std::shared_ptr<Value> > staticProperties;
+    std::unordered_map<Symbol, Function *> methods;
+    std::unordered_map<Symbol, Function *> staticMethods;
+    std::unordered_map<Symbol, Value> staticProperties;
 
-    virtual std::shared_ptr<Value> instantiate(const std::vector<std::shared_ptr<Value> > &arguments) = 0;
+    virtual Value instantiate(const std::vector<Value> &arguments) = 0;
 
-    virtual void invokeMethod(const std::string &methodName, Object *target,
-                              const std::vector<std::shared_ptr<Value> > &arguments) = 0;
+    virtual void invokeMethod(Symbol methodName, Object *target, const std::vector<Value> &arguments) = 0;
+
+    void trace(Heap &heap) override;
 };
 
 #endif // CLASS_H
@@ -0,0 +1,48 @@
+#include "Chunk.h"
+
+#include <limits>
+#include <stdexcept>
+
+void Chunk::write(const uint8_t byte) {
+    code.push_back(byte);
+}
+
+void Chunk::writeOp(const OpCode op) {
+    code.push_back(static_cast<uint8_t>(op));
+}
+
+void Chunk::writeShort(const uint16_t operand) {
+    code.push_back(static_cast<uint8_t>(operand >> 8));
+    code.push_back(static_cast<uint8_t>(operand & 0xff));
+}
+
+void Chunk::patchShort(const size_t offset, const uint16_t operand) {
+    code[offset] = static_cast<uint8_t>(operand >> 8);
+    code[offset + 1] = static_cast<uint8_t>(operand & 0xff);
+}
+
+uint16_t Chunk::addConstant(Value value) {
+    // A string that occurs more than once in the program gets one constant
+    if (value.isString()) {
+        if (const auto it = stringConstants_.find(value); it != stringConstants_.end()) {
+            return it->second;
+        }
+    }
+    if (constants.size() > numeric_limits<uint16_t>::max()) {
+        throw runtime_error("Too many constants in one program.");
+    }
+    const auto index = static_cast<uint16_t>(constants.size());
+    if (value.isString()) {
+        stringConstants_.emplace(value, index);
+    }
+    constants.push_back(move(value));
+    return index;
+}
+
+uint16_t Chunk::addName(const Symbol name) {
+    if (names.size() > numeric_limits<uint16_t>::max()) {
+        throw runtime_error("Too many names in one program.");
+    }
+    names.push_back(name);
+    return static_cast<uint16_t>(names.size() - 1);
+}
@@ -0,0 +1,117 @@
+#ifndef CHUNK_H
+#define CHUNK_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "value/Value.h"
+#include "../../include/Symbol.h"
+
+using namespace std;
+
+// Instructions understood by the VM. Operands follow the opcode inline as
+// big-endian 16-bit values; the comment lists them in order.
+enum class OpCode : uint8_t {
+    CONSTANT, // constant index
+    NIL,
+    TRUE,
+    FALSE,
+    POP, // the popped value becomes the statement result
+
+    DEFINE_LOCAL, // slot, pops the initializer
+    GET_LOCAL, // slot
+    SET_LOCAL, // slot, leaves the assigned value on the stack
+    GET_GLOBAL, // name index
+    SET_GLOBAL, // name index
+    GET_PROPERTY, // name index, inline cache index
+
+    ADD,
+    SUBTRACT,
+    MULTIPLY,
+    DIVIDE,
+    MODULO,
+    EQUAL,
+    NOT_EQUAL,
+    STRICT_EQUAL,
+    STRICT_NOT_EQUAL,
+    LESS,
+    LESS_EQUAL,
+    GREATER,
+    GREATER_EQUAL,
+    BITWISE_AND,
+    BITWISE_OR,
+    BITWISE_XOR,
+    LEFT_SHIFT,
+    RIGHT_SHIFT,
+    UNSIGNED_RIGHT_SHIFT,
+    NEGATE,
+    NOT,
+    BITWISE_NOT,
+    TRUTHY,
+
+    JUMP, // forward offset
+    JUMP_IF_FALSE, // forward offset, condition stays on the stack
+    LOOP, // backward offset
+
+    CALL, // argument count
+    PRINT_RESULT, // prints the last expression result of a top-level statement
+    HALT,
+};
+
+// Bytes taken by an instruction, its operands included
+inline size_t instructionLength(const OpCode op) {
+    switch (op) {
+        case OpCode::CONSTANT:
+        case OpCode::DEFINE_LOCAL:
+        case OpCode::GET_LOCAL:
+        case OpCode::SET_LOCAL:
+        case OpCode::GET_GLOBAL:
+        case OpCode::SET_GLOBAL:
+        case OpCode::JUMP:
+        case OpCode::JUMP_IF_FALSE:
+        case OpCode::LOOP:
+        case OpCode::CALL:
+            return 3;
+        case OpCode::GET_PROPERTY:
+            return 5;
+        default:
+            return 1;
+    }
+}
+
+// A compiled program: flat bytecode plus its constants and names pools
+class Chunk {
+public:
+    vector<uint8_t> code;
+    vector<Value> constants;
+    vector<Symbol> names; // Global and property names referenced by the code
+
+    // Number of local variable slots the program needs at its deepest nesting
+    size_t slotCount = 0;
+
+    // Number of property access sites, each of which gets its own InlineCache in the VM
+    size_t cacheCount = 0;
+
+    void write(uint8_t byte);
+
+    void writeOp(OpCode op);
+
+    void writeShort(uint16_t operand);
+
+    void patchShort(size_t offset, uint16_t operand);
+
+    uint16_t addConstant(Value value);
+
+    uint16_t addName(Symbol name);
+
+    [[nodiscard]] uint16_t readShort(const size_t offset) const {
+        return static_cast<uint16_t>(code[offset] << 8 | code[offset + 1]);
+    }
+
+private:
+    unordered_map<Value, uint16_t> stringConstants_; // Index of each string in the constants pool
+};
+
+#endif // CHUNK_H
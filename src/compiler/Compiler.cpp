@@ -0,0 +1,303 @@
+#include "Compiler.h"
+
+#include <limits>
+#include <stdexcept>
+
+#include "ast/AST.h"
+
+using namespace std;
+
+
+Chunk Compiler::compile(const vector<unique_ptr<Statement> > &statements) {
+    chunk_ = Chunk();
+    locals_.clear();
+    scopeDepth_ = 0;
+    names_.clear();
+
+    for (const auto &statement: statements) {
+        statement->accept(*this);
+        emit(OpCode::PRINT_RESULT);
+    }
+    emit(OpCode::HALT);
+
+    return move(chunk_);
+}
+
+Value Compiler::visitLiteralExpression(LiteralExpression *expression) {
+    const Value &value = expression->getValue();
+    if (value.isNull()) {
+        emit(OpCode::NIL);
+    } else if (value.isBool()) {
+        emit(value.asBool() ? OpCode::TRUE : OpCode::FALSE);
+    } else {
+        emit(OpCode::CONSTANT, chunk_.addConstant(value));
+    }
+    return {};
+}
+
+Value Compiler::visitIdentifierExpression(IdentifierExpression *expression) {
+    const int slot = resolveLocal(expression->getName());
+    if (slot >= 0) {
+        emit(OpCode::GET_LOCAL, static_cast<uint16_t>(slot));
+    } else {
+        emit(OpCode::GET_GLOBAL, nameIndex(expression->getName()));
+    }
+    return {};
+}
+
+Value Compiler::visitBinaryExpression(BinaryExpression *expression) {
+    expression->getLeft()->accept(*this);
+    expression->getRight()->accept(*this);
+
+    switch (expression->getOperator()) {
+        case BinaryExpression::Operator::ADD: emit(OpCode::ADD);
+            break;
+        case BinaryExpression::Operator::SUBTRACT: emit(OpCode::SUBTRACT);
+            break;
+        case BinaryExpression::Operator::MULTIPLY: emit(OpCode::MULTIPLY);
+            break;
+        case BinaryExpression::Operator::DIVIDE: emit(OpCode::DIVIDE);
+            break;
+        case BinaryExpression::Operator::MODULO: emit(OpCode::MODULO);
+            break;
+        case BinaryExpression::Operator::EQUAL: emit(OpCode::EQUAL);
+            break;
+        case BinaryExpression::Operator::NOT_EQUAL: emit(OpCode::NOT_EQUAL);
+            break;
+        case BinaryExpression::Operator::STRICT_EQUAL: emit(OpCode::STRICT_EQUAL);
+            break;
+        case BinaryExpression::Operator::STRICT_NOT_EQUAL: emit(OpCode::STRICT_NOT_EQUAL);
+            break;
+        case BinaryExpression::Operator::LESS: emit(OpCode::LESS);
+            break;
+        case BinaryExpression::Operator::LESS_EQUAL: emit(OpCode::LESS_EQUAL);
+            break;
+        case BinaryExpression::Operator::GREATER: emit(OpCode::GREATER);
+            break;
+        case BinaryExpression::Operator::GREATER_EQUAL: emit(OpCode::GREATER_EQUAL);
+            break;
+        case BinaryExpression::Operator::BITWISE_AND: emit(OpCode::BITWISE_AND);
+            break;
+        case BinaryExpression::Operator::BITWISE_OR: emit(OpCode::BITWISE_OR);
+            break;
+        case BinaryExpression::Operator::BITWISE_XOR: emit(OpCode::BITWISE_XOR);
+            break;
+        case BinaryExpression::Operator::LEFT_SHIFT: emit(OpCode::LEFT_SHIFT);
+            break;
+        case BinaryExpression::Operator::RIGHT_SHIFT: emit(OpCode::RIGHT_SHIFT);
+            break;
+        case BinaryExpression::Operator::UNSIGNED_RIGHT_SHIFT: emit(OpCode::UNSIGNED_RIGHT_SHIFT);
+            break;
+        default:
+            throw runtime_error("Unknown binary operator");
+    }
+    return {};
+}
+
+Value Compiler::visitUnaryExpression(UnaryExpression *expression) {
+    expression->getRight()->accept(*this);
+    switch (expression->getOperator()) {
+        case UnaryExpression::Operator::Negate: emit(OpCode::NEGATE);
+            break;
+        case UnaryExpression::Operator::Not: emit(OpCode::NOT);
+            break;
+        case UnaryExpression::Operator::BitwiseNot: emit(OpCode::BITWISE_NOT);
+            break;
+    }
+    return {};
+}
+
+Value Compiler::visitAssignmentExpression(AssignmentExpression *expression) {
+    expression->getValue()->accept(*this);
+
+    const Symbol name = expression->getName();
+    const int slot = resolveLocal(name);
+    if (slot < 0) {
+        emit(OpCode::SET_GLOBAL, nameIndex(name));
+        return {};
+    }
+    if (locals_[slot].isConst) {
+        throw runtime_error("Cannot reassign constant variable '" + name.str() + "'.");
+    }
+    emit(OpCode::SET_LOCAL, static_cast<uint16_t>(slot));
+    return {};
+}
+
+Value Compiler::visitLogicalExpression(LogicalExpression *expression) {
+    expression->getLeft()->accept(*this);
+
+    if (expression->getOperator() == LogicalExpression::Operator::And) {
+        // A falsy left operand decides the result; skip the right one
+        const size_t endJump = emitJump(OpCode::JUMP_IF_FALSE);
+        emit(OpCode::POP);
+        expression->getRight()->accept(*this);
+        patchJump(endJump);
+    } else {
+        // A truthy left operand decides the result; jump over the unconditional skip
+        const size_t elseJump = emitJump(OpCode::JUMP_IF_FALSE);
+        const size_t endJump = emitJump(OpCode::JUMP);
+        patchJump(elseJump);
+        emit(OpCode::POP);
+        expression->getRight()->accept(*this);
+        patchJump(endJump);
+    }
+
+    emit(OpCode::TRUTHY);
+    return {};
+}
+
+Value Compiler::visitFunctionCallExpression(FunctionCallExpression *expression) {
+    expression->getCallee()->accept(*this);
+    for (const auto &argument: expression->getArguments()) {
+        argument->accept(*this);
+    }
+    emit(OpCode::CALL, static_cast<uint16_t>(expression->getArguments().size()));
+    return {};
+}
+
+Value Compiler::visitGetExpression(GetExpression *expression) {
+    expression->getObject()->accept(*this);
+    if (chunk_.cacheCount > numeric_limits<uint16_t>::max()) {
+        throw runtime_error("Too many property accesses in one program.");
+    }
+    emit(OpCode::GET_PROPERTY, nameIndex(expression->getName()));
+    chunk_.writeShort(static_cast<uint16_t>(chunk_.cacheCount++));
+    return {};
+}
+
+void Compiler::visitExpressionStatement(ExpressionStatement *statement) {
+    statement->getExpression()->accept(*this);
+    emit(OpCode::POP);
+}
+
+void Compiler::visitVariableDeclaration(VariableDeclaration *statement) {
+    const Symbol name = statement->getName();
+    for (auto local = locals_.rbegin(); local != locals_.rend() && local->depth == scopeDepth_; ++local) {
+        if (local->name == name) {
+            throw runtime_error("Variable '" + name.str() + "' is already defined.");
+        }
+    }
+
+    // The initializer is compiled before the variable exists, so `let x = x;` reads the outer x
+    if (statement->hasInitializer()) {
+        statement->getInitializer()->accept(*this);
+    } else {
+        emit(OpCode::NIL);
+    }
+
+    if (locals_.size() > numeric_limits<uint16_t>::max()) {
+        throw runtime_error("Too many local variables in one program.");
+    }
+    locals_.push_back({name, scopeDepth_, statement->getTypeName() == "const"});
+    chunk_.slotCount = max(chunk_.slotCount, locals_.size());
+    emit(OpCode::DEFINE_LOCAL, static_cast<uint16_t>(locals_.size() - 1));
+}
+
+void Compiler::visitBlockStatement(BlockStatement *statement) {
+    beginScope();
+    for (const auto &inner: statement->getStatements()) {
+        if (inner) {
+            inner->accept(*this);
+        }
+    }
+    endScope();
+}
+
+void Compiler::visitIfStatement(IfStatement *statement) {
+    statement->getCondition()->accept(*this);
+
+    const size_t thenJump = emitJump(OpCode::JUMP_IF_FALSE);
+    emit(OpCode::POP);
+    statement->getThenBranch()->accept(*this);
+
+    const size_t elseJump = emitJump(OpCode::JUMP);
+    patchJump(thenJump);
+    emit(OpCode::POP);
+    if (statement->getElseBranch()) {
+        statement->getElseBranch()->accept(*this);
+    }
+    patchJump(elseJump);
+}
+
+void Compiler::visitWhileStatement(WhileStatement *statement) {
+    const size_t loopStart = chunk_.code.size();
+    statement->getCondition()->accept(*this);
+
+    const size_t exitJump = emitJump(OpCode::JUMP_IF_FALSE);
+    emit(OpCode::POP);
+    statement->getBody()->accept(*this);
+    emitLoop(loopStart);
+
+    patchJump(exitJump);
+    emit(OpCode::POP);
+}
+
+// The tree walkers run return statements and function declarations as no-ops, so they compile to
+// no code: the statement leaves the previous result in place, exactly as it does there
+void Compiler::visitReturnStatement(ReturnStatement *statement) {
+}
+
+void Compiler::visitFunctionDeclaration(FunctionDeclaration *statement) {
+}
+
+void Compiler::emit(const OpCode op) {
+    chunk_.writeOp(op);
+}
+
+void Compiler::emit(const OpCode op, const uint16_t operand) {
+    chunk_.writeOp(op);
+    chunk_.writeShort(operand);
+}
+
+// Emits a jump with a placeholder offset and returns the offset of its operand for patchJump
+size_t Compiler::emitJump(const OpCode op) {
+    emit(op, 0xffff);
+    return chunk_.code.size() - 2;
+}
+
+void Compiler::patchJump(const size_t operandOffset) {
+    const size_t jump = chunk_.code.size() - operandOffset - 2;
+    if (jump > numeric_limits<uint16_t>::max()) {
+        throw runtime_error("Too much code to jump over.");
+    }
+    chunk_.patchShort(operandOffset, static_cast<uint16_t>(jump));
+}
+
+void Compiler::emitLoop(const size_t loopStart) {
+    const size_t jump = chunk_.code.size() + 3 - loopStart;
+    if (jump > numeric_limits<uint16_t>::max()) {
+        throw runtime_error("Loop body too large.");
+    }
+    emit(OpCode::LOOP, static_cast<uint16_t>(jump));
+}
+
+void Compiler::beginScope() {
+    scopeDepth_++;
+}
+
+// Slots of variables leaving scope are simply reused by later declarations
+void Compiler::endScope() {
+    scopeDepth_--;
+    while (!locals_.empty() && locals_.back().depth > scopeDepth_) {
+        locals_.pop_back();
+    }
+}
+
+int Compiler::resolveLocal(const Symbol name) const {
+    for (int slot = static_cast<int>(locals_.size()) - 1; slot >= 0; slot--) {
+        if (locals_[slot].name == name) {
+            return slot;
+        }
+    }
+    return -1;
+}
+
+uint16_t Compiler::nameIndex(const Symbol name) {
+    const auto it = names_.find(name);
+    if (it != names_.end()) {
+        return it->second;
+    }
+    const uint16_t index = chunk_.addName(name);
+    names_.emplace(name, index);
+    return index;
+}
@@ -0,0 +1,83 @@
+#ifndef COMPILER_H
+#define COMPILER_H
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Chunk.h"
+#include "../visitor/Visitor.h"
+
+// Lowers a parsed program into a Chunk for the VM. Variables declared by the script are
+// resolved to local slots at compile time; anything else (the builtins) is looked up by name.
+class Compiler : public Visitor {
+public:
+    // Compiles a whole program; throws runtime_error for constructs the VM cannot run
+    Chunk compile(const vector<unique_ptr<Statement> > &statements);
+
+    // Visitor methods for expressions
+    Value visitLiteralExpression(LiteralExpression *expression) override;
+
+    Value visitIdentifierExpression(IdentifierExpression *expression) override;
+
+    Value visitBinaryExpression(BinaryExpression *expression) override;
+
+    Value visitUnaryExpression(UnaryExpression *expression) override;
+
+    Value visitAssignmentExpression(AssignmentExpression *expression) override;
+
+    Value visitLogicalExpression(LogicalExpression *expression) override;
+
+    Value visitFunctionCallExpression(FunctionCallExpression *expression) override;
+
+    Value visitGetExpression(GetExpression *expression) override;
+
+    // Visitor methods for statements
+    void visitExpressionStatement(ExpressionStatement *statement) override;
+
+    void visitVariableDeclaration(VariableDeclaration *statement) override;
+
+    void visitBlockStatement(BlockStatement *statement) override;
+
+    void visitIfStatement(IfStatement *statement) override;
+
+    void visitWhileStatement(WhileStatement *statement) override;
+
+    void visitReturnStatement(ReturnStatement *statement) override;
+
+    void visitFunctionDeclaration(FunctionDeclaration *statement) override;
+
+private:
+    struct Local {
+        Symbol name;
+        int depth;
+        bool isConst;
+    };
+
+    Chunk chunk_;
+    vector<Local> locals_;
+    int scopeDepth_ = 0;
+    unordered_map<Symbol, uint16_t> names_; // Names already in the chunk's names pool
+
+    // Helper methods
+    void emit(OpCode op);
+
+    void emit(OpCode op, uint16_t operand);
+
+    size_t emitJump(OpCode op);
+
+    void patchJump(size_t operandOffset);
+
+    void emitLoop(size_t loopStart);
+
+    void beginScope();
+
+    void endScope();
+
+    [[nodiscard]] int resolveLocal(Symbol name) const;
+
+    uint16_t nameIndex(Symbol name);
+};
+
+#endif // COMPILER_H
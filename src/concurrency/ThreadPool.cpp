@@ -0,0 +1,119 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <utility>
+
+using namespace std;
+
+thread_local const ThreadPool *ThreadPool::owner_ = nullptr;
+thread_local size_t ThreadPool::self_ = 0;
+
+ThreadPool::ThreadPool(size_t threadCount) {
+    threadCount = max<size_t>(threadCount, 1);
+    for (size_t i = 0; i < threadCount; i++) {
+        workers_.push_back(make_unique<Worker>());
+    }
+    for (size_t i = 0; i < threadCount; i++) {
+        threads_.emplace_back([this, i] { run(i); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        lock_guard lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    for (thread &worker: threads_) {
+        worker.join();
+    }
+}
+
+void ThreadPool::submit(function<void()> task) {
+    // Tasks submitted from a worker stay on its own deque; others are dealt out round-robin.
+    // The task is counted before it is pushed, so a worker can never take it uncounted.
+    size_t target;
+    {
+        lock_guard lock(mutex_);
+        target = owner_ == this ? self_ : nextWorker_++ % workers_.size();
+        pending_++;
+        queued_++;
+    }
+    {
+        Worker &worker = *workers_[target];
+        lock_guard lock(worker.lock);
+        worker.tasks.push_back(move(task));
+    }
+    wake_.notify_one();
+}
+
+void ThreadPool::wait() {
+    unique_lock lock(mutex_);
+    idle_.wait(lock, [this] { return pending_ == 0; });
+    if (failure_) {
+        rethrow_exception(exchange(failure_, nullptr));
+    }
+}
+
+bool ThreadPool::tryTake(const size_t self, function<void()> &task) {
+    // Newest task of our own first
+    {
+        Worker &worker = *workers_[self];
+        lock_guard lock(worker.lock);
+        if (!worker.tasks.empty()) {
+            task = move(worker.tasks.back());
+            worker.tasks.pop_back();
+            return true;
+        }
+    }
+
+    // Otherwise steal the oldest task of the next worker that has one
+    for (size_t i = 1; i < workers_.size(); i++) {
+        Worker &victim = *workers_[(self + i) % workers_.size()];
+        lock_guard lock(victim.lock);
+        if (!victim.tasks.empty()) {
+            task = move(victim.tasks.front());
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::run(const size_t self) {
+    owner_ = this;
+    self_ = self;
+
+    while (true) {
+        {
+            unique_lock lock(mutex_);
+            wake_.wait(lock, [this] { return queued_ > 0 || stopping_; });
+            if (queued_ == 0) {
+                return; // Stopping and nothing left to run
+            }
+        }
+
+        function<void()> task;
+        if (!tryTake(self, task)) {
+            continue; // Another worker got there first, or the task is still being pushed
+        }
+        {
+            lock_guard lock(mutex_);
+            queued_--;
+        }
+
+        try {
+            task();
+        } catch (...) {
+            lock_guard lock(mutex_);
+            if (!failure_) {
+                failure_ = current_exception();
+            }
+        }
+
+        lock_guard lock(mutex_);
+        if (--pending_ == 0) {
+            idle_.notify_all();
+        }
+    }
+}
@@ -0,0 +1,67 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// Fixed set of worker threads with one task deque each. A worker takes its newest task first
+// (so tasks it submits itself run while their data is still warm) and, once its own deque is
+// empty, steals the oldest task from another worker, so uneven tasks still keep every core busy.
+class ThreadPool {
+public:
+    explicit ThreadPool(size_t threadCount = thread::hardware_concurrency());
+
+    // Finishes every queued task before joining the workers
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    void submit(function<void()> task);
+
+    // Blocks until every task submitted so far has run. Rethrows the first exception a task threw.
+    void wait();
+
+    [[nodiscard]] size_t getThreadCount() const {
+        return threads_.size();
+    }
+
+private:
+    struct Worker {
+        mutex lock;
+        deque<function<void()> > tasks;
+    };
+
+    vector<unique_ptr<Worker> > workers_;
+    vector<thread> threads_;
+
+    // Guards the counters below; workers sleep on wake_ while nothing is queued
+    mutex mutex_;
+    condition_variable wake_;
+    condition_variable idle_;
+    size_t queued_ = 0; // Tasks sitting in some deque
+    size_t pending_ = 0; // Tasks submitted and not yet finished
+    size_t nextWorker_ = 0; // Deque the next task from outside the pool goes to
+    bool stopping_ = false;
+    exception_ptr failure_;
+
+    // Index of the pool worker running on this thread, if any
+    static thread_local const ThreadPool *owner_;
+    static thread_local size_t self_;
+
+    bool tryTake(size_t self, function<void()> &task);
+
+    void run(size_t self);
+};
+
+#endif //THREADPOOL_H
@@ -5,54 +5,105 @@
 #include <string>
 #include <memory>
 #include <stdexcept>
+#include <vector>
 #include "../value/Value.h"
+#include "../gc/Heap.h"
+#include "../../include/Symbol.h"
 
 using namespace std;
 
-class Environment {
+// A scope holds two kinds of variables: those the Resolver assigned a slot, stored in a flat
+// vector, and those looked up by name (builtins and anything the Resolver did not see).
+// Environments are owned by the garbage collector; allocate them with Heap::allocate.
+class Environment : public GcObject {
 public:
-    Environment(shared_ptr<Environment> enclosing = nullptr)
+    explicit Environment(Environment *enclosing = nullptr)
         : enclosing_(enclosing) {
     }
 
     // Define a variable in the current environment with its const status
-    void define(const string &name, const shared_ptr<Value> &value, bool isConst = false) {
-        if (values_.find(name) != values_.end()) {
-            throw runtime_error("Variable '" + name + "' is already defined.");
+    void define(const Symbol name, const Value &value, bool isConst = false) {
+        Heap::writeBarrier(this, value);
+        if (!values_.try_emplace(name, value).second) {
+            throw runtime_error("Variable '" + name.str() + "' is already defined.");
         }
-        values_[name] = value;
         isConst_[name] = isConst; // Track whether this variable is const
     }
 
     // Get the value of a variable, looking in the current and outer environments
-    shared_ptr<Value> get(const string &name) {
-        if (values_.find(name) != values_.end()) {
-            return values_[name];
+    const Value &get(const Symbol name) {
+        const auto it = values_.find(name);
+        if (it != values_.end()) {
+            return it->second;
         }
         if (enclosing_ != nullptr) {
             return enclosing_->get(name); // Look in the outer scope
         }
-        throw runtime_error("Undefined variable '" + name + "'.");
+        throw runtime_error("Undefined variable '" + name.str() + "'.");
     }
 
     // Assign a value to an existing variable, enforcing const rules
-    void assign(const string &name, const shared_ptr<Value> &value) {
-        if (values_.find(name) != values_.end()) {
+    void assign(const Symbol name, const Value &value) {
+        const auto it = values_.find(name);
+        if (it != values_.end()) {
             if (isConst_[name]) {
-                throw runtime_error("Cannot reassign constant variable '" + name + "'.");
+                throw runtime_error("Cannot reassign constant variable '" + name.str() + "'.");
             }
-            values_[name] = value;
+            Heap::writeBarrier(this, it->second, value);
+            it->second = value;
         } else if (enclosing_ != nullptr) {
             enclosing_->assign(name, value);
         } else {
-            throw runtime_error("Undefined variable '" + name + "'.");
+            throw runtime_error("Undefined variable '" + name.str() + "'.");
+        }
+    }
+
+    // Slot-indexed access for resolved variables. Const-ness was already checked by the Resolver.
+    void defineAt(const size_t slot, const Value &value) {
+        if (slot >= slots_.size()) {
+            slots_.resize(slot + 1);
+        }
+        Heap::writeBarrier(this, slots_[slot], value);
+        slots_[slot] = value;
+    }
+
+    const Value &getAt(const int depth, const size_t slot) {
+        return ancestor(depth)->slots_[slot];
+    }
+
+    void assignAt(const int depth, const size_t slot, const Value &value) {
+        Environment *environment = ancestor(depth);
+        Heap::writeBarrier(environment, environment->slots_[slot], value);
+        environment->slots_[slot] = value;
+    }
+
+    [[nodiscard]] Environment *getEnclosing() const {
+        return enclosing_;
+    }
+
+    void trace(Heap &heap) override {
+        heap.mark(enclosing_);
+        for (auto &[name, value]: values_) {
+            heap.mark(value);
+        }
+        for (Value &value: slots_) {
+            heap.mark(value);
         }
     }
 
 private:
-    unordered_map<string, shared_ptr<Value> > values_; // Stores variables and their values
-    unordered_map<string, bool> isConst_; // Tracks whether a variable is const
-    shared_ptr<Environment> enclosing_; // Enclosing (outer) scope
+    unordered_map<Symbol, Value> values_; // Stores variables and their values
+    unordered_map<Symbol, bool> isConst_; // Tracks whether a variable is const
+    vector<Value> slots_; // Resolved variables, indexed by slot
+    Environment *enclosing_; // Enclosing (outer) scope
+
+    Environment *ancestor(const int depth) {
+        Environment *environment = this;
+        for (int i = 0; i < depth; i++) {
+            environment = environment->enclosing_;
+        }
+        return environment;
+    }
 };
 
 #endif // ENVIRONMENT_H
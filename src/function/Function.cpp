@@ -1,3 +1,10 @@
 #include "Function.h"
 #include "value/Value.h"
 #include "object/Object.h"
+
+void Function::trace(Heap &heap) {
+    Object::trace(heap);
+    for (auto &[name, property]: properties) {
+        heap.mark(property);
+    }
+}
@@ -1,7 +1,7 @@
 #ifndef FUNCTION_H
 #define FUNCTION_H
 
-#include <map>
+#include <unordered_map>
 #include <string>
 #include <memory>
 #include <vector>
@@ -11,11 +11,12 @@ class Value; // Forward declaration
 
 class Function : public Object {
 public:
-    virtual ~Function() = default;
+    // Builtins without a result return null
+    virtual Value call(const std::vector<Value> &args) = 0;
 
-    virtual std::shared_ptr<Value> call(const std::vector<std::shared_ptr<Value> > &args) = 0;
+    std::unordered_map<Symbol, Value> properties;
 
-    std::map<std::string, std::shared_ptr<Value> > properties;
+    void trace(Heap &heap) override;
 };
 
 #endif // FUNCTION_H
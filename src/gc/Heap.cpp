@@ -0,0 +1,295 @@
+#include "Heap.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <iomanip>
+#include <limits>
+#include <ostream>
+
+#include "value/Value.h"
+#include "object/Object.h"
+
+using namespace std;
+
+namespace {
+    double millisecondsSince(const chrono::steady_clock::time_point start) {
+        return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    }
+
+    // Increments look at the clock once per this many objects marked or swept
+    constexpr size_t clockInterval = 64;
+}
+
+void PauseHistogram::record(const double milliseconds) {
+    const auto microseconds = static_cast<uint64_t>(milliseconds * 1000);
+    counts[min<size_t>(bit_width(microseconds), BUCKETS - 1)]++;
+}
+
+void PauseHistogram::print(ostream &out, const char *name) const {
+    out << "GC: " << name << " pauses:";
+    if (ranges::all_of(counts, [](const size_t count) { return count == 0; })) {
+        out << " none";
+    }
+    for (size_t i = 0; i < BUCKETS; i++) {
+        if (counts[i] == 0) {
+            continue;
+        }
+        if (i == BUCKETS - 1) {
+            out << " >=" << (1u << (i - 1)) << "us " << counts[i];
+        } else {
+            out << " <" << (1u << i) << "us " << counts[i];
+        }
+    }
+    out << endl;
+}
+
+void GcStats::print(ostream &out) const {
+    out << fixed << setprecision(3);
+    out << "GC: " << collections << " collection(s) in " << increments << " increment(s), " << totalPauseMilliseconds
+            << " ms total pause, " << maxPauseMilliseconds << " ms max pause" << endl;
+    out << "GC: " << minorCollections << " minor collection(s), " << totalMinorPauseMilliseconds
+            << " ms total pause, " << maxMinorPauseMilliseconds << " ms max pause, " << objectsPromoted
+            << " object(s) / " << bytesPromoted << " bytes promoted" << endl;
+    out << "GC: " << objectsAllocated << " object(s) / " << bytesAllocated << " bytes allocated, " << objectsFreed
+            << " object(s) / " << bytesFreed << " bytes freed, " << liveBytes << " bytes live" << endl;
+    pauses.print(out, "increment");
+    minorPauses.print(out, "minor");
+}
+
+Heap::Heap()
+    : nurseryMemory_(make_unique_for_overwrite<max_align_t[]>(NURSERY_SIZE / sizeof(max_align_t))),
+      nurseryTop_(nurseryStart()), nurseryEnd_(nurseryStart() + NURSERY_SIZE) {
+    // Even the smallest objects cannot outnumber this, so allocation never grows the vector
+    nursery_.reserve(NURSERY_SIZE / nurserySize(sizeof(GcObject)));
+}
+
+Heap::~Heap() {
+    for (GcObject *object: nursery_) {
+        object->~GcObject();
+    }
+    for (GcObject *list: {objects_, unswept_}) {
+        while (list) {
+            GcObject *next = list->next_;
+            delete list;
+            list = next;
+        }
+    }
+}
+
+Heap &Heap::current() {
+    static thread_local Heap heap;
+    return heap;
+}
+
+void Heap::addRoots(RootSource *source) {
+    roots_.push_back(source);
+}
+
+void Heap::removeRoots(RootSource *source) {
+    erase(roots_, source);
+}
+
+void Heap::mark(Value &value) {
+    if (isReference(value)) {
+        Object *object = value.payload().object;
+        mark(object);
+        value.payload().object = object;
+    }
+}
+
+// A minor collection moves the young objects and leaves old ones alone; a young object that was
+// already moved just has its reference updated. The old generation's marking only shades.
+void Heap::markObject(GcObject *&object) {
+    if (collectingNursery_) {
+        if (isYoung(object)) {
+            object = object->marked_ ? object->next_ : promote(object);
+        }
+        return;
+    }
+    shade(object);
+}
+
+// Young objects were allocated after the collection started, so it keeps them either way
+void Heap::shade(GcObject *object) {
+    if (!object->marked_ && !isYoung(object)) {
+        object->marked_ = true;
+        grayStack_.push_back(object);
+    }
+}
+
+void Heap::shadeIfMarking(Object *object) {
+    if (phase_ == Phase::MARKING) {
+        shade(object);
+    }
+}
+
+// Moves a surviving young object to the old generation, leaving the address of the copy behind
+// for the other references to it. While marking, the copy is black like any new old object.
+GcObject *Heap::promote(GcObject *object) {
+    GcObject *moved = object->relocate_(object);
+    object->marked_ = true;
+    object->next_ = moved;
+    moved->marked_ = phase_ == Phase::MARKING;
+    moved->remembered_ = false;
+    link(moved);
+    moved_.push_back(moved);
+    stats_.objectsPromoted++;
+    stats_.bytesPromoted += moved->size_;
+    allocatedSinceCollection_ += moved->size_;
+    oldBytes_ += moved->size_;
+    return moved;
+}
+
+void Heap::collectNursery() {
+    const auto start = chrono::steady_clock::now();
+
+    // Move everything the roots and the remembered old objects reference, then everything the
+    // moved objects reference, tracing through a worklist rather than recursion
+    collectingNursery_ = true;
+    for (RootSource *source: roots_) {
+        source->traceRoots(*this);
+    }
+    for (GcObject *object: remembered_) {
+        object->remembered_ = false;
+        object->trace(*this);
+    }
+    remembered_.clear();
+    while (!moved_.empty()) {
+        GcObject *object = moved_.back();
+        moved_.pop_back();
+        object->trace(*this);
+    }
+    collectingNursery_ = false;
+
+    // Empty the nursery: what was not moved is garbage, and what was is an empty shell now
+    for (GcObject *object: nursery_) {
+        if (!object->marked_) {
+            stats_.objectsFreed++;
+            stats_.bytesFreed += object->size_;
+            stats_.liveBytes -= object->size_;
+        }
+        object->~GcObject();
+    }
+    nursery_.clear();
+    nurseryTop_ = nurseryStart();
+
+    const double pause = millisecondsSince(start);
+    stats_.minorCollections++;
+    stats_.totalMinorPauseMilliseconds += pause;
+    stats_.maxMinorPauseMilliseconds = max(stats_.maxMinorPauseMilliseconds, pause);
+    stats_.minorPauses.record(pause);
+}
+
+void Heap::collect() {
+    const double budget = pauseBudget_;
+    pauseBudget_ = numeric_limits<double>::infinity();
+    if (phase_ != Phase::IDLE) {
+        collectIncrement();
+    }
+    collectIncrement();
+    pauseBudget_ = budget;
+}
+
+void Heap::collectIncrement() {
+    const auto start = chrono::steady_clock::now();
+    const auto deadline = isinf(pauseBudget_)
+                              ? chrono::steady_clock::time_point::max()
+                              : start + chrono::duration_cast<chrono::steady_clock::duration>(
+                                    chrono::duration<double, milli>(pauseBudget_));
+
+    if (phase_ == Phase::IDLE) {
+        startCollection();
+    }
+    if (phase_ == Phase::MARKING && markUntil(deadline)) {
+        // Every reachable old object is black; sweep the rest while new ones go to a fresh list
+        phase_ = Phase::SWEEPING;
+        unswept_ = objects_;
+        objects_ = nullptr;
+    }
+    if (phase_ == Phase::SWEEPING && sweepUntil(deadline)) {
+        phase_ = Phase::IDLE;
+        stats_.collections++;
+        allocatedSinceCollection_ = 0;
+        threshold_ = max(MIN_THRESHOLD, 2 * oldBytes_);
+    }
+
+    const double pause = millisecondsSince(start);
+    stats_.increments++;
+    stats_.totalPauseMilliseconds += pause;
+    stats_.maxPauseMilliseconds = max(stats_.maxPauseMilliseconds, pause);
+    stats_.pauses.record(pause);
+    allocatedSinceIncrement_ = 0;
+}
+
+// Takes the snapshot: with the nursery empty, the roots and the permanent objects are the
+// first gray objects
+void Heap::startCollection() {
+    collectNursery();
+    phase_ = Phase::MARKING;
+    for (RootSource *source: roots_) {
+        source->traceRoots(*this);
+    }
+    for (GcObject *&object: permanent_) {
+        mark(object);
+    }
+}
+
+bool Heap::markUntil(const chrono::steady_clock::time_point deadline) {
+    for (size_t traced = 1; !grayStack_.empty(); traced++) {
+        GcObject *object = grayStack_.back();
+        grayStack_.pop_back();
+        object->trace(*this);
+        if (traced % clockInterval == 0 && chrono::steady_clock::now() >= deadline) {
+            return grayStack_.empty();
+        }
+    }
+    return true;
+}
+
+// Frees the unmarked objects and moves the marked ones back to the old generation, white again
+// for the next collection
+bool Heap::sweepUntil(const chrono::steady_clock::time_point deadline) {
+    for (size_t swept = 1; unswept_; swept++) {
+        GcObject *object = unswept_;
+        unswept_ = object->next_;
+        if (object->marked_) {
+            object->marked_ = false;
+            link(object);
+        } else {
+            stats_.objectsFreed++;
+            stats_.bytesFreed += object->size_;
+            stats_.liveBytes -= object->size_;
+            oldBytes_ -= object->size_;
+            delete object;
+        }
+        if (swept % clockInterval == 0 && chrono::steady_clock::now() >= deadline) {
+            return unswept_ == nullptr;
+        }
+    }
+    return true;
+}
+
+void Heap::count(GcObject *object, const size_t size) {
+    object->size_ = static_cast<uint32_t>(size);
+    stats_.objectsAllocated++;
+    stats_.bytesAllocated += size;
+    stats_.liveBytes += size;
+    allocatedSinceIncrement_ += size;
+}
+
+void Heap::link(GcObject *object) {
+    object->next_ = objects_;
+    objects_ = object;
+}
+
+void Heap::remember(GcObject *object) {
+    object->remembered_ = true;
+    remembered_.push_back(object);
+}
+
+void Heap::rememberIfOld(GcObject *owner, const void *referenced) {
+    if (isYoung(referenced) && !isYoung(owner)) {
+        remember(owner);
+    }
+}
@@ -0,0 +1,309 @@
+#ifndef HEAP_H
+#define HEAP_H
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+#include "value/Value.h"
+
+class Heap;
+
+// Base class of everything the garbage collector manages: objects, classes, functions and
+// environments. Objects are only ever deleted by a collection that found them unreachable, or
+// with the heap itself.
+//
+// Managed types must be move- or copy-constructible: a minor collection moves the young objects
+// that survive it out of the nursery.
+class GcObject {
+public:
+    virtual ~GcObject() = default;
+
+    // Marks every object this one references. A minor collection moves young objects, so the
+    // references are passed by reference and may be updated.
+    virtual void trace(Heap &heap) = 0;
+
+private:
+    friend class Heap;
+
+    // Moves the object to the old generation and returns the new copy
+    using Relocate = GcObject *(*)(GcObject *from);
+
+    GcObject *next_ = nullptr; // Next old object; in the nursery, where a moved object went
+    Relocate relocate_ = nullptr;
+    uint32_t size_ = 0;
+    bool marked_ = false; // Gray or black; in the nursery: moved to the old generation
+    bool remembered_ = false;
+};
+
+// Anything outside the heap that holds references into it, such as an engine's environments or
+// value stack. Registered sources are asked to mark their references at the start of every collection.
+class RootSource {
+public:
+    virtual ~RootSource() = default;
+
+    virtual void traceRoots(Heap &heap) = 0;
+};
+
+// Pause counts in power-of-two buckets: under 1 us, then [1, 2) us, [2, 4) us and so on, with
+// the last bucket open-ended
+struct PauseHistogram {
+    static constexpr size_t BUCKETS = 16;
+
+    std::array<size_t, BUCKETS> counts{};
+
+    void record(double milliseconds);
+
+    // One line listing the non-empty buckets
+    void print(std::ostream &out, const char *name) const;
+};
+
+// Running totals for --gc-stats. Sizes are the objects' own sizes, not counting the buffers their
+// containers own. The pause times of the old generation are per increment.
+struct GcStats {
+    size_t collections = 0;
+    size_t increments = 0;
+    size_t objectsAllocated = 0;
+    size_t bytesAllocated = 0;
+    size_t objectsFreed = 0;
+    size_t bytesFreed = 0;
+    size_t liveBytes = 0;
+    double totalPauseMilliseconds = 0;
+    double maxPauseMilliseconds = 0;
+
+    size_t minorCollections = 0;
+    size_t objectsPromoted = 0;
+    size_t bytesPromoted = 0;
+    double totalMinorPauseMilliseconds = 0;
+    double maxMinorPauseMilliseconds = 0;
+
+    PauseHistogram pauses;
+    PauseHistogram minorPauses;
+
+    void print(std::ostream &out) const;
+};
+
+// A precise, generational collector. It is not thread-safe and needs no atomics: every thread
+// has its own heap (see current()), and objects never move between threads.
+//
+// New objects are bump-allocated in a fixed-size nursery. A minor collection moves the ones
+// still reachable from the roots, or from old objects that were handed a young reference, into
+// the old generation, and then empties the nursery, so it costs in proportion to what survives
+// plus one destructor call per dead object.
+//
+// The old generation is collected by incremental, non-moving mark-sweep. A cycle empties the
+// nursery, shades the roots gray, and then marks and sweeps in increments that each stop at the
+// pause budget, with the program running in between. Marking is tri-color: white objects are
+// unmarked, gray ones are marked but not traced yet, black ones are marked and traced. It keeps a
+// snapshot of the heap at the start of the cycle: the write barrier shades any reference that is
+// overwritten while marking, and objects that enter the old generation meanwhile are black, so
+// everything reachable at the start or allocated since survives the cycle without the roots
+// having to be scanned again.
+//
+// Collections only run at safepoints, which the engines reach between statements and on loop
+// back edges. At those points every live reference is in a registered RootSource, a permanent
+// object, or an object reachable from them, never only in a C++ temporary or local variable.
+class Heap {
+public:
+    // Start collecting the old generation once this many bytes entered it since the last
+    // collection, or twice the bytes that survived it if that is more
+    static constexpr size_t MIN_THRESHOLD = 1 << 20;
+
+    // While a collection of the old generation is under way, run an increment at the first
+    // safepoint after this many bytes were allocated since the last one
+    static constexpr size_t INCREMENT_INTERVAL = 64 << 10;
+
+    static constexpr double DEFAULT_PAUSE_BUDGET = 1.0; // Milliseconds per increment
+
+    static constexpr size_t NURSERY_SIZE = 256 << 10;
+
+    // Empty the nursery at the first safepoint past this much use; the rest takes the allocations
+    // made before the next safepoint, and anything beyond it is allocated old
+    static constexpr size_t NURSERY_TRIGGER = NURSERY_SIZE / 4 * 3;
+
+    Heap();
+
+    Heap(const Heap &) = delete;
+
+    Heap &operator=(const Heap &) = delete;
+
+    // Frees every object, reachable or not
+    ~Heap();
+
+    // The calling thread's heap
+    static Heap &current();
+
+    template<typename T, typename... Args>
+    T *allocate(Args &&... args) {
+        static_assert(alignof(T) <= alignof(std::max_align_t));
+        constexpr size_t size = nurserySize(sizeof(T));
+        if (size > static_cast<size_t>(nurseryEnd_ - nurseryTop_)) {
+            return allocateOld<T>(std::forward<Args>(args)...);
+        }
+        // Bump first: the constructor may allocate too
+        void *memory = nurseryTop_;
+        nurseryTop_ += size;
+        T *object = new(memory) T(std::forward<Args>(args)...);
+        object->relocate_ = [](GcObject *from) -> GcObject * {
+            return new T(std::move(*static_cast<T *>(from)));
+        };
+        nursery_.push_back(object);
+        count(object, sizeof(T));
+        return object;
+    }
+
+    // As allocate, but the object is a root for as long as the heap lives, and it never moves
+    template<typename T, typename... Args>
+    T *allocatePermanent(Args &&... args) {
+        T *object = allocateOld<T>(std::forward<Args>(args)...);
+        permanent_.push_back(object);
+        return object;
+    }
+
+    void addRoots(RootSource *source);
+
+    void removeRoots(RootSource *source);
+
+    // Marks an object and, before the collection ends, everything it references. If the object
+    // is young, a minor collection moves it and updates `object`.
+    template<typename T>
+    void mark(T *&object) {
+        if (object) {
+            GcObject *base = object;
+            markObject(base);
+            object = static_cast<T *>(base);
+        }
+    }
+
+    void mark(Value &value);
+
+    // Call when storing `value` into `owner`. An old object handed a young reference is
+    // remembered, so the next minor collection treats it as a root.
+    static void writeBarrier(GcObject *owner, const Value &value) {
+        if (!owner->remembered_ && isReference(value)) {
+            current().rememberIfOld(owner, value.payload().object);
+        }
+    }
+
+    // As above, when `value` overwrites `old`, which is shaded while marking
+    static void writeBarrier(GcObject *owner, const Value &old, const Value &value) {
+        if (isReference(old)) {
+            current().shadeIfMarking(old.payload().object);
+        }
+        writeBarrier(owner, value);
+    }
+
+    // Collects the nursery when it fills up, and starts or continues a collection of the old
+    // generation as allocation goes on. Only call where no reference is held outside the roots.
+    void safepoint() {
+        if (static_cast<size_t>(nurseryTop_ - nurseryStart()) >= NURSERY_TRIGGER) {
+            collectNursery();
+        }
+        if (phase_ == Phase::IDLE ? allocatedSinceCollection_ >= threshold_
+                                  : allocatedSinceIncrement_ >= INCREMENT_INTERVAL) {
+            collectIncrement();
+        }
+    }
+
+    // Finishes the collection under way, if any, then collects both generations in one pause
+    void collect();
+
+    // Moves the nursery's survivors to the old generation and empties it
+    void collectNursery();
+
+    // How long one increment of an old generation collection may take, in milliseconds
+    void setPauseBudget(const double milliseconds) {
+        pauseBudget_ = milliseconds;
+    }
+
+    [[nodiscard]] const GcStats &getStats() const {
+        return stats_;
+    }
+
+private:
+    enum class Phase { IDLE, MARKING, SWEEPING };
+
+    std::unique_ptr<std::max_align_t[]> nurseryMemory_;
+    char *nurseryTop_;
+    char *nurseryEnd_;
+    std::vector<GcObject *> nursery_; // Objects in the nursery, in allocation order
+    std::vector<GcObject *> remembered_; // Old objects that may reference young ones
+    GcObject *objects_ = nullptr; // The old generation
+    GcObject *unswept_ = nullptr; // While sweeping, the old objects the sweep has not reached yet
+    std::vector<GcObject *> permanent_;
+    std::vector<RootSource *> roots_;
+    std::vector<GcObject *> grayStack_; // Gray objects of the old generation
+    std::vector<GcObject *> moved_; // Objects moved by a minor collection whose references are not updated yet
+    Phase phase_ = Phase::IDLE;
+    bool collectingNursery_ = false;
+    double pauseBudget_ = DEFAULT_PAUSE_BUDGET;
+    size_t allocatedSinceCollection_ = 0; // Bytes allocated old or promoted
+    size_t allocatedSinceIncrement_ = 0; // Bytes allocated anywhere
+    size_t threshold_ = MIN_THRESHOLD;
+    size_t oldBytes_ = 0;
+    GcStats stats_;
+
+    static constexpr size_t nurserySize(const size_t size) {
+        return (size + alignof(std::max_align_t) - 1) & ~(alignof(std::max_align_t) - 1);
+    }
+
+    [[nodiscard]] char *nurseryStart() const {
+        return reinterpret_cast<char *>(nurseryMemory_.get());
+    }
+
+    static bool isReference(const Value &value) {
+        return value.isObject() || value.isClass() || value.isFunction();
+    }
+
+    [[nodiscard]] bool isYoung(const void *address) const {
+        return address >= nurseryStart() && address < nurseryEnd_;
+    }
+
+    // Old objects are allocated outside the nursery and start out remembered, since their
+    // constructor may store young references without a write barrier
+    template<typename T, typename... Args>
+    T *allocateOld(Args &&... args) {
+        T *object = new T(std::forward<Args>(args)...);
+        object->marked_ = phase_ == Phase::MARKING;
+        link(object);
+        remember(object);
+        count(object, sizeof(T));
+        allocatedSinceCollection_ += sizeof(T);
+        oldBytes_ += sizeof(T);
+        return object;
+    }
+
+    void count(GcObject *object, size_t size);
+
+    void link(GcObject *object);
+
+    void remember(GcObject *object);
+
+    void rememberIfOld(GcObject *owner, const void *referenced);
+
+    void shadeIfMarking(Object *object);
+
+    void markObject(GcObject *&object);
+
+    void shade(GcObject *object);
+
+    GcObject *promote(GcObject *object);
+
+    // Runs one increment of the old generation's collection, starting one if none is under way
+    void collectIncrement();
+
+    void startCollection();
+
+    // Each returns whether it finished before `deadline`
+    bool markUntil(std::chrono::steady_clock::time_point deadline);
+
+    bool sweepUntil(std::chrono::steady_clock::time_point deadline);
+};
+
+#endif // HEAP_H
@@ -9,233 +9,191 @@
 #include "class/Class.h"
 #include "function/Function.h"
 #include "value/Value.h"
+#include "ast/FlatAST.h"
+#include "interpreter/Operators.h"
 
 using namespace std;
 
 
+namespace {
+    // The fast path a node quickens to once it has seen numbers; operators without one stay generic
+    BinaryExpression::Specialization specializeForDoubles(const BinaryExpression::Operator op) {
+        using Operator = BinaryExpression::Operator;
+        using Specialization = BinaryExpression::Specialization;
+        switch (op) {
+            case Operator::ADD: return Specialization::ADD_DOUBLE;
+            case Operator::SUBTRACT: return Specialization::SUBTRACT_DOUBLE;
+            case Operator::MULTIPLY: return Specialization::MULTIPLY_DOUBLE;
+            case Operator::DIVIDE: return Specialization::DIVIDE_DOUBLE;
+            case Operator::MODULO: return Specialization::MODULO_DOUBLE;
+            case Operator::EQUAL: return Specialization::EQUAL_DOUBLE;
+            case Operator::NOT_EQUAL: return Specialization::NOT_EQUAL_DOUBLE;
+            case Operator::LESS: return Specialization::LESS_DOUBLE;
+            case Operator::LESS_EQUAL: return Specialization::LESS_EQUAL_DOUBLE;
+            case Operator::GREATER: return Specialization::GREATER_DOUBLE;
+            case Operator::GREATER_EQUAL: return Specialization::GREATER_EQUAL_DOUBLE;
+            default: return Specialization::GENERIC;
+        }
+    }
+}
+
 Interpreter::Interpreter()
-    : environment_(make_shared<Environment>()) // Initialize with a new Environment
+    : heap_(Heap::current()), environment_(heap_.allocate<Environment>()) // Initialize with a new Environment
 {
+    heap_.addRoots(this);
     registerBuiltIns();
 }
 
+Interpreter::~Interpreter() {
+    heap_.removeRoots(this);
+}
+
+// Collections only happen at safepoints between statements, where every live value is in an
+// environment or in lastValue: no statement runs while an expression is half evaluated.
+void Interpreter::traceRoots(Heap &heap) {
+    heap.mark(environment_);
+    heap.mark(lastValue);
+}
+
 
 void Interpreter::interpret(const vector<unique_ptr<Statement> > &statements) {
     try {
         for (const auto &statement: statements) {
             statement->accept(*this);
             cout << "Statement Result: " << endl;
-            this->lastValue->getValue()->printValue();
+            this->lastValue.printValue();
+            heap_.safepoint();
         }
     } catch (const exception &e) {
         cerr << "Runtime error: " << e.what() << endl;
     }
 }
 
-shared_ptr<Value> Interpreter::visitLiteralExpression(LiteralExpression *expression) {
-    auto val = expression->getValue();
-    auto value = std::make_shared<Value>(val.get());
-    setLastValue(value);
-    return value;
+void Interpreter::interpret(FlatProgram &program) {
+    try {
+        for (const uint32_t statement: program.statements) {
+            execute(program, statement);
+            cout << "Statement Result: " << endl;
+            this->lastValue.printValue();
+            heap_.safepoint();
+        }
+    } catch (const exception &e) {
+        cerr << "Runtime error: " << e.what() << endl;
+    }
 }
 
-
-shared_ptr<Value> Interpreter::visitIdentifierExpression(IdentifierExpression *expression) {
-    const std::string &variableName = expression->getName();
-    shared_ptr<Value> value = environment_->get(variableName);
-    setLastValue(value);
-    return value;
+// Expressions return their Value directly; lastValue is only updated where a statement completes
+// an expression, which is all the per-statement result printing observes.
+Value Interpreter::visitLiteralExpression(LiteralExpression *expression) {
+    return expression->getValue();
 }
 
-shared_ptr<Value> Interpreter::visitBinaryExpression(BinaryExpression *expression) {
-    // Step 1: Evaluate the left operand
-    expression->getLeft()->accept(*this);
 
-    const shared_ptr<Value> left = this->lastValue;
-
-    // Step 2: Evaluate the right operand
-    expression->getRight()->accept(*this);
-    const shared_ptr<Value> right = this->lastValue;
-
-    // Early exit for division by zero
-    if (expression->getOperator() == BinaryExpression::Operator::DIVIDE && right->asDouble() == 0) {
-        throw runtime_error("Division by zero");
-    }
-
-    // Step 3: Ensure both operands are numbers and convert to double if needed
-
-    // Check if the left value is a number
-    const double leftValue = left->asDouble();
-
-    // Check if the right value is a number
-    const double rightValue = right->asDouble();
-
-    switch (expression->getOperator()) {
-        case BinaryExpression::Operator::ADD: {
-            this->lastValue = make_shared<Value>(Value(leftValue + rightValue));
-            break;
-        }
-        case BinaryExpression::Operator::SUBTRACT: {
-            this->lastValue = make_shared<Value>(Value(leftValue - rightValue));
-            break;
-        }
-        case BinaryExpression::Operator::MULTIPLY: {
-            this->lastValue = make_shared<Value>(Value(leftValue * rightValue));
-            break;
-        }
-        case BinaryExpression::Operator::DIVIDE: {
-            this->lastValue = make_shared<Value>(Value(leftValue / rightValue));
-            break;
-        }
-        case BinaryExpression::Operator::MODULO: {
-            this->lastValue = make_shared<Value>(Value(fmod(leftValue, rightValue)));
-            break;
-        }
-        case BinaryExpression::Operator::EQUAL: {
-            this->lastValue = make_shared<Value>(Value(leftValue == rightValue));
-            break;
-        }
-        case BinaryExpression::Operator::NOT_EQUAL: {
-            this->lastValue = make_shared<Value>(Value(leftValue != rightValue));
-            break;
-        }
-
-        //TODO: Add strict equality and strict inequality
+Value Interpreter::visitIdentifierExpression(IdentifierExpression *expression) {
+    return expression->getDepth() >= 0
+               ? environment_->getAt(expression->getDepth(), expression->getSlot())
+               : environment_->get(expression->getName());
+}
 
-        case BinaryExpression::Operator::LESS: {
-            this->lastValue = make_shared<Value>(Value(leftValue < rightValue));
-            break;
-        }
-        case BinaryExpression::Operator::LESS_EQUAL: {
-            this->lastValue = make_shared<Value>(Value(leftValue <= rightValue));
-            break;
-        }
-        case BinaryExpression::Operator::GREATER: {
-            this->lastValue = make_shared<Value>(Value(leftValue > rightValue));
-            break;
-        }
-        case BinaryExpression::Operator::GREATER_EQUAL: {
-            this->lastValue = make_shared<Value>(Value(leftValue >= rightValue));
-            break;
-        }
-        case BinaryExpression::Operator::LOGICAL_AND: {
-            this->lastValue = make_shared<Value>(Value(isTruthy(left) && isTruthy(right)));
-            break;
-        }
-        case BinaryExpression::Operator::LOGICAL_OR: {
-            this->lastValue = make_shared<Value>(Value(isTruthy(left) || isTruthy(right)));
-            break;
-        }
-        default: {
-            throw runtime_error("Unknown binary operator");
+Value Interpreter::visitBinaryExpression(BinaryExpression *expression) {
+    using Specialization = BinaryExpression::Specialization;
+    const Value left = expression->getLeft()->accept(*this);
+    const Value right = expression->getRight()->accept(*this);
+
+    // Quickened nodes go straight to their operation while the guard holds: both operands numbers
+    const Specialization specialization = expression->getSpecialization();
+    if (left.isDouble() && right.isDouble()) {
+        const double a = left.asDouble();
+        const double b = right.asDouble();
+        switch (specialization) {
+            case Specialization::ADD_DOUBLE: return Value(a + b);
+            case Specialization::SUBTRACT_DOUBLE: return Value(a - b);
+            case Specialization::MULTIPLY_DOUBLE: return Value(a * b);
+            case Specialization::DIVIDE_DOUBLE:
+                if (b == 0) {
+                    throw runtime_error("Division by zero");
+                }
+                return Value(a / b);
+            case Specialization::MODULO_DOUBLE: return Value(fmod(a, b));
+            case Specialization::EQUAL_DOUBLE: return Value(a == b);
+            case Specialization::NOT_EQUAL_DOUBLE: return Value(a != b);
+            case Specialization::LESS_DOUBLE: return Value(a < b);
+            case Specialization::LESS_EQUAL_DOUBLE: return Value(a <= b);
+            case Specialization::GREATER_DOUBLE: return Value(a > b);
+            case Specialization::GREATER_EQUAL_DOUBLE: return Value(a >= b);
+            case Specialization::UNINITIALIZED:
+                expression->specialize(specializeForDoubles(expression->getOperator()));
+                break;
+            case Specialization::GENERIC:
+                break;
         }
+    } else if (specialization != Specialization::GENERIC) {
+        // Deoptimize: this site is not numbers-only after all
+        expression->specialize(Specialization::GENERIC);
     }
-    return this->lastValue;
+    return applyBinary(expression->getOperator(), left, right);
 }
 
 
-shared_ptr<Value> Interpreter::visitUnaryExpression(UnaryExpression *expression) {
-    return shared_ptr<Value>();
+Value Interpreter::visitUnaryExpression(UnaryExpression *expression) {
+    const Value right = expression->getRight()->accept(*this);
+    return applyUnary(expression->getOperator(), right);
 }
 
-shared_ptr<Value> Interpreter::visitAssignmentExpression(AssignmentExpression *expression) {
-    string variableName = expression->getName();
+Value Interpreter::visitAssignmentExpression(AssignmentExpression *expression) {
+    const Symbol variableName = expression->getName();
 
     // Evaluate the right-hand side of the assignment
-    expression->getValue()->accept(*this);
-    shared_ptr<Value> value = lastValue;
+    Value value = expression->getValue()->accept(*this);
 
     // Assign the evaluated value to the variable in the environment
-    environment_->assign(variableName, value);
+    if (expression->getDepth() >= 0) {
+        environment_->assignAt(expression->getDepth(), expression->getSlot(), value);
+    } else {
+        environment_->assign(variableName, value);
+    }
 
     return value;
 }
 
-shared_ptr<Value> Interpreter::visitLogicalExpression(LogicalExpression *expression) {
-    return shared_ptr<Value>();
+Value Interpreter::visitLogicalExpression(LogicalExpression *expression) {
+    const bool left = expression->getLeft()->accept(*this).isTruthy();
+
+    // Short-circuit: the right operand is only evaluated when it can change the result
+    if (expression->getOperator() == LogicalExpression::Operator::And ? left : !left) {
+        return Value(expression->getRight()->accept(*this).isTruthy());
+    }
+    return Value(left);
 }
 
-shared_ptr<Value> Interpreter::visitFunctionCallExpression(FunctionCallExpression *expression) {
+Value Interpreter::visitFunctionCallExpression(FunctionCallExpression *expression) {
     // Evaluate the callee
-    expression->getCallee()->accept(*this);
-    shared_ptr<Value> calleeValue = lastValue;
+    const Value callee = expression->getCallee()->accept(*this);
 
     // Evaluate arguments
-    std::vector<std::shared_ptr<Value> > arguments;
+    std::vector<Value> arguments;
+    arguments.reserve(expression->getArguments().size());
     for (const auto &argExpr: expression->getArguments()) {
-        auto argValue = argExpr->accept(*this);
-        arguments.push_back(argValue);
+        arguments.push_back(argExpr->accept(*this));
     }
 
-    if (calleeValue->isFunction()) {
-        auto function = calleeValue->asFunction();
-
-        // For methods, the first argument can be the 'this' context
-        shared_ptr<Value> result = function->call(arguments);
-        setLastValue(result);
-        return result;
-    } else {
+    if (!callee.isFunction()) {
         throw std::runtime_error("Can only call functions.");
     }
-}
-
-
-shared_ptr<Value> Interpreter::visitGetExpression(GetExpression *expression) {
-    // Evaluate the object
-    expression->getObject()->accept(*this);
-    shared_ptr<Value> objectValue = lastValue;
 
-    const std::string &propertyName = expression->getName();
+    // For methods, the first argument can be the 'this' context
+    return callee.asFunction()->call(arguments);
+}
 
-    if (objectValue->isClass()) {
-        auto classObject = objectValue->asClass();
-        // Check for static methods
-        if (classObject->staticMethods.contains(propertyName)) {
-            auto method = classObject->staticMethods[propertyName];
-            shared_ptr<Value> value = make_shared<Value>(method);
-            setLastValue(value);
-            return value;
-        }
-        // Check for static properties
-        if (classObject->staticProperties.contains(propertyName)) {
-            shared_ptr<Value> value = classObject->staticProperties[propertyName];
-            setLastValue(value);
-            return value;
-        }
-    } else if (objectValue->isFunction()) {
-        auto functionObject = objectValue->asFunction();
-        // Check for properties on the function object
-        if (functionObject->properties.contains(propertyName)) {
-            shared_ptr<Value> value = functionObject->properties[propertyName];
-            setLastValue(value);
-            return value;
-        }
-    } else if (objectValue->isObject()) {
-        auto object = objectValue->asObject();
-        // Check for instance properties
-        if (object->fields.contains(propertyName)) {
-            shared_ptr<Value> value = object->fields[propertyName];
-            setLastValue(value);
-            return value;
-        }
-        // Check for instance methods
-        auto classType = object->classType.get();
-        if (classType->methods.contains(propertyName)) {
-            auto method = classType->methods[propertyName];
-            shared_ptr<Value> value = make_shared<Value>(method);
-            setLastValue(value);
-            return value;
-        }
-    } else {
-        throw std::runtime_error("Only objects, classes, and functions have properties.");
-    }
 
-    throw std::runtime_error("Undefined property '" + propertyName + "'.");
+Value Interpreter::visitGetExpression(GetExpression *expression) {
+    const Value object = expression->getObject()->accept(*this);
+    return expression->getCache().get(object, expression->getName());
 }
 
 
 void Interpreter::visitExpressionStatement(ExpressionStatement *statement) {
-    statement->getExpression()->accept(*this);
+    lastValue = statement->getExpression()->accept(*this);
 }
 
 void Interpreter::visitVariableDeclaration(VariableDeclaration *statement) {
@@ -244,15 +202,15 @@ void Interpreter::visitVariableDeclaration(VariableDeclaration *statement) {
         throw runtime_error("Null pointer passed to visitVariableDeclaration.");
     }
 
-    string variableName = statement->getName();
+    const Symbol variableName = statement->getName();
 
     // Ensure that the environment is valid
     if (!environment_) {
         throw runtime_error("Environment is not initialized.");
     }
 
-    // Evaluate the initializer if it exists, or set it to a default value
-    shared_ptr<Value> value;
+    // Evaluate the initializer if it exists; a variable declared without one holds null
+    Value value;
     if (statement->hasInitializer()) {
         // Check that the initializer is not null
         if (!statement->getInitializer()) {
@@ -260,24 +218,41 @@ void Interpreter::visitVariableDeclaration(VariableDeclaration *statement) {
         }
 
         // Evaluate the initializer expression
-        statement->getInitializer()->accept(*this);
-        value = lastValue;
-    } else {
-        value = shared_ptr<Value>(); // Default value (could be null or undefined)
+        value = statement->getInitializer()->accept(*this);
+        lastValue = value;
     }
-    bool isConst = statement->getTypeName() == "const";
     // Define the variable in the current environment
-    environment_->define(variableName, value, isConst);
+    if (statement->getSlot() >= 0) {
+        environment_->defineAt(statement->getSlot(), value);
+    } else {
+        bool isConst = statement->getTypeName() == "const";
+        environment_->define(variableName, value, isConst);
+    }
 }
 
 
 void Interpreter::visitBlockStatement(BlockStatement *statement) {
+    executeBlock(statement->getStatements(), heap_.allocate<Environment>(environment_));
 }
 
 void Interpreter::visitIfStatement(IfStatement *statement) {
+    lastValue = statement->getCondition()->accept(*this);
+    if (lastValue.isTruthy()) {
+        statement->getThenBranch()->accept(*this);
+    } else if (statement->getElseBranch()) {
+        statement->getElseBranch()->accept(*this);
+    }
 }
 
 void Interpreter::visitWhileStatement(WhileStatement *statement) {
+    while (true) {
+        lastValue = statement->getCondition()->accept(*this);
+        if (!lastValue.isTruthy()) {
+            break;
+        }
+        statement->getBody()->accept(*this);
+        heap_.safepoint();
+    }
 }
 
 void Interpreter::visitReturnStatement(ReturnStatement *statement) {
@@ -286,48 +261,143 @@ void Interpreter::visitReturnStatement(ReturnStatement *statement) {
 void Interpreter::visitFunctionDeclaration(FunctionDeclaration *statement) {
 }
 
-void Interpreter::executeBlock(const vector<unique_ptr<Statement> > &statements,
-                               const shared_ptr<Environment> &newEnvironment) {
+// `newEnvironment` must enclose the current one. A minor collection between the statements may
+// move both, so the block leaves its scope through the enclosing pointer, which the collector keeps
+// up to date, rather than through a saved copy.
+void Interpreter::executeBlock(const vector<unique_ptr<Statement> > &statements, Environment *newEnvironment) {
+    environment_ = newEnvironment;
+    try {
+        for (const auto &statement: statements) {
+            if (statement) {
+                statement->accept(*this);
+                heap_.safepoint();
+            }
+        }
+    } catch (...) {
+        environment_ = environment_->getEnclosing();
+        throw;
+    }
+    environment_ = environment_->getEnclosing();
 }
 
-bool Interpreter::isTruthy(const shared_ptr<Value> &value) {
-    switch (value->getType()) {
-        case TokenType::BOOLEAN_LITERAL:
-            return value->asBool(); // If it's a boolean, return its actual value (true or false)
-        case TokenType::DOUBLE_LITERAL:
-            return value->asDouble() != 0; // Numbers are truthy if they're not zero
-        case TokenType::STRING_LITERAL:
-            return !value->asString().empty(); // Non-empty strings are truthy
+// Flat walk: the same semantics as the visitor methods above, dispatched on FlatNode::kind
+Value Interpreter::evaluate(FlatProgram &program, const uint32_t index) {
+    const FlatNode &node = program.nodes[index];
+    switch (node.kind) {
+        case FlatKind::LITERAL:
+            return program.literals[node.a];
+        case FlatKind::IDENTIFIER:
+            return node.b != FlatProgram::NONE
+                       ? environment_->getAt(static_cast<int>(node.b), node.c)
+                       : environment_->get(program.names[node.a]);
+        case FlatKind::BINARY: {
+            const Value left = evaluate(program, node.a);
+            const Value right = evaluate(program, node.b);
+            return applyBinary(static_cast<BinaryExpression::Operator>(node.op), left, right);
+        }
+        case FlatKind::UNARY: {
+            const Value right = evaluate(program, node.a);
+            return applyUnary(static_cast<UnaryExpression::Operator>(node.op), right);
+        }
+        case FlatKind::ASSIGNMENT: {
+            Value value = evaluate(program, node.b);
+            if (node.c != FlatProgram::NONE) {
+                environment_->assignAt(static_cast<int>(node.c), node.d, value);
+            } else {
+                environment_->assign(program.names[node.a], value);
+            }
+            return value;
+        }
+        case FlatKind::LOGICAL: {
+            const bool left = evaluate(program, node.a).isTruthy();
+            // Short-circuit: the right operand is only evaluated when it can change the result
+            if (static_cast<LogicalExpression::Operator>(node.op) == LogicalExpression::Operator::And ? left : !left) {
+                return Value(evaluate(program, node.b).isTruthy());
+            }
+            return Value(left);
+        }
+        case FlatKind::CALL: {
+            const Value callee = evaluate(program, node.a);
+            vector<Value> arguments;
+            arguments.reserve(node.c);
+            for (uint32_t i = 0; i < node.c; i++) {
+                arguments.push_back(evaluate(program, program.lists[node.b + i]));
+            }
+            if (!callee.isFunction()) {
+                throw runtime_error("Can only call functions.");
+            }
+            return callee.asFunction()->call(arguments);
+        }
+        case FlatKind::GET: {
+            const Value object = evaluate(program, node.a);
+            return program.caches[node.c].get(object, program.names[node.b]);
+        }
         default:
-            return false; // Other cases could default to false, depending on your needs
+            throw runtime_error("Expected an expression node.");
     }
 }
 
-void Interpreter::setLastValue(const shared_ptr<Value> &value) {
-    // Handle all the types your interpreter supports
-    if (value->isDouble()) {
-        this->lastValue = value; // Already a double, no conversion needed
-    } else if (value->isBool()) {
-        this->lastValue = value; // Set as a boolean
-    } else if (value->isString()) {
-        this->lastValue = value; // Set as a string
-    } else if (value->isObject()) {
-        this->lastValue = value; // Set as an object
-    } else if (value->isFunction()) {
-        this->lastValue = value; // Set as a function
-    } else if (value->isClass()) {
-        this->lastValue = value; // Set as a class
-    } else if (value->isNull()) {
-        this->lastValue = value; // Set as null
-    } else {
-        throw runtime_error("Unsupported type encountered");
+void Interpreter::execute(FlatProgram &program, const uint32_t index) {
+    const FlatNode &node = program.nodes[index];
+    switch (node.kind) {
+        case FlatKind::EXPRESSION_STATEMENT:
+            lastValue = evaluate(program, node.a);
+            break;
+        case FlatKind::VARIABLE_DECLARATION: {
+            Value value;
+            if (node.b != FlatProgram::NONE) {
+                value = evaluate(program, node.b);
+                lastValue = value;
+            }
+            if (node.c != FlatProgram::NONE) {
+                environment_->defineAt(node.c, value);
+            } else {
+                environment_->define(program.names[node.a], value, node.op != 0);
+            }
+            break;
+        }
+        case FlatKind::BLOCK: {
+            environment_ = heap_.allocate<Environment>(environment_);
+            try {
+                for (uint32_t i = 0; i < node.b; i++) {
+                    execute(program, program.lists[node.a + i]);
+                    heap_.safepoint();
+                }
+            } catch (...) {
+                environment_ = environment_->getEnclosing();
+                throw;
+            }
+            environment_ = environment_->getEnclosing();
+            break;
+        }
+        case FlatKind::IF:
+            lastValue = evaluate(program, node.a);
+            if (lastValue.isTruthy()) {
+                execute(program, node.b);
+            } else if (node.c != FlatProgram::NONE) {
+                execute(program, node.c);
+            }
+            break;
+        case FlatKind::WHILE:
+            while (true) {
+                lastValue = evaluate(program, node.a);
+                if (!lastValue.isTruthy()) {
+                    break;
+                }
+                execute(program, node.b);
+                heap_.safepoint();
+            }
+            break;
+        case FlatKind::RETURN:
+        case FlatKind::FUNCTION_DECLARATION:
+            break;
+        default:
+            throw runtime_error("Expected a statement node.");
     }
 }
 
 void Interpreter::registerBuiltIns() const {
-    const auto arrayClass = std::make_shared<ArrayClass>();
-    const auto arrayValue = make_shared<Value>(Value(std::static_pointer_cast<Class>(arrayClass)));
-    environment_->define("Array", arrayValue, true);
+    environment_->define(Symbol::intern("Array"), Value(ArrayClass::shared()), true);
 }
 
 
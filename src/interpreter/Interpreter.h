@@ -1,9 +1,11 @@
 #ifndef INTERPRETER_H
 #define INTERPRETER_H
 
+#include <cstdint>
 #include <memory>
 #include <vector>
 #include "../visitor/Visitor.h"
+#include "../gc/Heap.h"
 
 class Environment;
 class Value;
@@ -23,31 +25,42 @@ class BinaryExpression;
 class IdentifierExpression;
 class LiteralExpression;
 class Statement;
+struct FlatProgram;
 
-class Interpreter : public Visitor {
+// Registers itself with the calling thread's heap as a source of roots while it exists
+class Interpreter : public Visitor, public RootSource {
 public:
     Interpreter();
 
+    ~Interpreter() override;
+
+    Interpreter(const Interpreter &) = delete;
+
+    Interpreter &operator=(const Interpreter &) = delete;
+
     // Executes a list of statements (the program)
     void interpret(const vector<unique_ptr<Statement> > &statements);
 
+    // Executes a program produced by the Flattener, walking nodes by index instead of by visitor
+    void interpret(FlatProgram &program);
+
     //
     // Visitor methods for expressions
-    std::shared_ptr<Value> visitLiteralExpression(LiteralExpression *expression) override;
+    Value visitLiteralExpression(LiteralExpression *expression) override;
 
-    std::shared_ptr<Value> visitIdentifierExpression(IdentifierExpression *expression) override;
+    Value visitIdentifierExpression(IdentifierExpression *expression) override;
 
-    std::shared_ptr<Value> visitBinaryExpression(BinaryExpression *expression) override;
+    Value visitBinaryExpression(BinaryExpression *expression) override;
 
-    std::shared_ptr<Value> visitUnaryExpression(UnaryExpression *expression) override;
+    Value visitUnaryExpression(UnaryExpression *expression) override;
 
-    std::shared_ptr<Value> visitAssignmentExpression(AssignmentExpression *expression) override;
+    Value visitAssignmentExpression(AssignmentExpression *expression) override;
 
-    std::shared_ptr<Value> visitLogicalExpression(LogicalExpression *expression) override;
+    Value visitLogicalExpression(LogicalExpression *expression) override;
 
-    std::shared_ptr<Value> visitFunctionCallExpression(FunctionCallExpression *expression) override;
+    Value visitFunctionCallExpression(FunctionCallExpression *expression) override;
 
-    std::shared_ptr<Value> visitGetExpression(GetExpression *expression) override;
+    Value visitGetExpression(GetExpression *expression) override;
 
     // Visitor methods for statements
     void visitExpressionStatement(ExpressionStatement *statement) override;
@@ -64,6 +77,8 @@ public:
 
     void visitFunctionDeclaration(FunctionDeclaration *statement) override;
 
+    void traceRoots(Heap &heap) override;
+
     void ReturnException(const Value &value);
 
     // Exception class for returning from functions
@@ -75,18 +90,20 @@ public:
     };
 
 private:
+    Heap &heap_;
+
     // The environment representing the current scope
-    shared_ptr<Environment> environment_;
+    Environment *environment_;
 
-    std::shared_ptr<Value> lastValue = make_unique<Value>(Value());
+    // The value of the last expression a statement completed, printed after each top-level statement
+    Value lastValue;
 
     // Helper methods
-    static void executeBlock(const vector<unique_ptr<Statement> > &statements,
-                             const shared_ptr<Environment> &newEnvironment);
+    void executeBlock(const vector<unique_ptr<Statement> > &statements, Environment *newEnvironment);
 
-    static bool isTruthy(const shared_ptr<Value> &value);
+    Value evaluate(FlatProgram &program, uint32_t index);
 
-    void setLastValue(const shared_ptr<Value> &value);
+    void execute(FlatProgram &program, uint32_t index);
 
     void registerBuiltIns() const;
 };
@@ -0,0 +1,86 @@
+#include "Operators.h"
+
+#include <cmath>
+#include <stdexcept>
+
+using namespace std;
+
+Value applyBinary(const BinaryExpression::Operator op, const Value &left, const Value &right) {
+    // Adding two strings concatenates them
+    if (op == BinaryExpression::Operator::ADD && left.isString() && right.isString()) {
+        return Value::concatenate(left, right);
+    }
+
+    // Strict equality compares the operands' types and values as they are, so it never converts them
+    if (op == BinaryExpression::Operator::STRICT_EQUAL) {
+        return Value(left == right);
+    }
+    if (op == BinaryExpression::Operator::STRICT_NOT_EQUAL) {
+        return Value(!(left == right));
+    }
+
+    // Early exit for division by zero
+    if (op == BinaryExpression::Operator::DIVIDE && right.asDouble() == 0) {
+        throw runtime_error("Division by zero");
+    }
+
+    // Ensure both operands are numbers and convert to double if needed
+    const double leftValue = left.asDouble();
+    const double rightValue = right.asDouble();
+
+    switch (op) {
+        case BinaryExpression::Operator::ADD:
+            return Value(leftValue + rightValue);
+        case BinaryExpression::Operator::SUBTRACT:
+            return Value(leftValue - rightValue);
+        case BinaryExpression::Operator::MULTIPLY:
+            return Value(leftValue * rightValue);
+        case BinaryExpression::Operator::DIVIDE:
+            return Value(leftValue / rightValue);
+        case BinaryExpression::Operator::MODULO:
+            return Value(fmod(leftValue, rightValue));
+        case BinaryExpression::Operator::EQUAL:
+            return Value(leftValue == rightValue);
+        case BinaryExpression::Operator::NOT_EQUAL:
+            return Value(leftValue != rightValue);
+
+        case BinaryExpression::Operator::LESS:
+            return Value(leftValue < rightValue);
+        case BinaryExpression::Operator::LESS_EQUAL:
+            return Value(leftValue <= rightValue);
+        case BinaryExpression::Operator::GREATER:
+            return Value(leftValue > rightValue);
+        case BinaryExpression::Operator::GREATER_EQUAL:
+            return Value(leftValue >= rightValue);
+        case BinaryExpression::Operator::LOGICAL_AND:
+            return Value(left.isTruthy() && right.isTruthy());
+        case BinaryExpression::Operator::LOGICAL_OR:
+            return Value(left.isTruthy() || right.isTruthy());
+        case BinaryExpression::Operator::BITWISE_AND:
+            return Value(static_cast<double>(left.asInt32() & right.asInt32()));
+        case BinaryExpression::Operator::BITWISE_OR:
+            return Value(static_cast<double>(left.asInt32() | right.asInt32()));
+        case BinaryExpression::Operator::BITWISE_XOR:
+            return Value(static_cast<double>(left.asInt32() ^ right.asInt32()));
+        case BinaryExpression::Operator::LEFT_SHIFT:
+            return Value(static_cast<double>(left.asInt32() << (right.asInt32() & 31)));
+        case BinaryExpression::Operator::RIGHT_SHIFT:
+            return Value(static_cast<double>(left.asInt32() >> (right.asInt32() & 31)));
+        case BinaryExpression::Operator::UNSIGNED_RIGHT_SHIFT:
+            return Value(static_cast<double>(static_cast<uint32_t>(left.asInt32()) >> (right.asInt32() & 31)));
+        default:
+            throw runtime_error("Unknown binary operator");
+    }
+}
+
+Value applyUnary(const UnaryExpression::Operator op, const Value &operand) {
+    switch (op) {
+        case UnaryExpression::Operator::Negate:
+            return Value(-operand.asDouble());
+        case UnaryExpression::Operator::Not:
+            return Value(!operand.isTruthy());
+        case UnaryExpression::Operator::BitwiseNot:
+            return Value(static_cast<double>(~operand.asInt32()));
+    }
+    throw runtime_error("Unknown unary operator");
+}
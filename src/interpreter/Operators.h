@@ -0,0 +1,14 @@
+#ifndef OPERATORS_H
+#define OPERATORS_H
+
+#include "ast/AST.h"
+#include "value/Value.h"
+
+// Operator semantics shared by the tree walk, the flat walk and constant folding, so a folded
+// expression always has the value the Interpreter would have computed. Both throw
+// runtime_error on invalid operands (division by zero, a string where a number is expected).
+Value applyBinary(BinaryExpression::Operator op, const Value &left, const Value &right);
+
+Value applyUnary(UnaryExpression::Operator op, const Value &operand);
+
+#endif //OPERATORS_H
@@ -0,0 +1,95 @@
+#ifndef KEYWORDS_H
+#define KEYWORDS_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include "../../include/Token.h"
+
+using namespace std;
+
+// Reserved words the Lexer turns into keyword tokens instead of identifiers
+struct Keyword {
+    string_view text;
+    TokenType type;
+};
+
+inline constexpr Keyword keywords[] = {
+    {"if", TokenType::IF}, {"else", TokenType::ELSE}, {"switch", TokenType::SWITCH}, {"case", TokenType::CASE},
+    {"default", TokenType::DEFAULT}, {"for", TokenType::FOR}, {"while", TokenType::WHILE}, {"do", TokenType::DO},
+    {"break", TokenType::BREAK}, {"continue", TokenType::CONTINUE}, {"return", TokenType::RETURN},
+    {"try", TokenType::TRY}, {"catch", TokenType::CATCH}, {"finally", TokenType::FINALLY},
+    {"throw", TokenType::THROW}, {"new", TokenType::NEW}, {"delete", TokenType::DELETE},
+    {"let", TokenType::LET}, {"const", TokenType::CONST}, {"var", TokenType::VAR},
+};
+
+// Perfect hash over the keywords, built at compile time. A word hashes on its length and its
+// first and last bytes, with multipliers searched for so that no two keywords share a bucket;
+// classifying a word then costs one hash and at most one comparison against a keyword.
+namespace keyword_hash {
+    constexpr size_t SIZE = 64; // Power of two, a few times the keyword count
+
+    struct Factors {
+        uint32_t first;
+        uint32_t last;
+    };
+
+    constexpr size_t bucket(const string_view word, const Factors factors) {
+        return (static_cast<uint8_t>(word.front()) * factors.first + static_cast<uint8_t>(word.back()) * factors.last +
+                word.size()) & (SIZE - 1);
+    }
+
+    constexpr bool isPerfect(const Factors factors) {
+        array<bool, SIZE> used{};
+        for (const Keyword &keyword: keywords) {
+            const size_t index = bucket(keyword.text, factors);
+            if (used[index]) {
+                return false;
+            }
+            used[index] = true;
+        }
+        return true;
+    }
+
+    constexpr Factors findFactors() {
+        for (uint32_t first = 1; first < SIZE; first++) {
+            for (uint32_t last = 1; last < SIZE; last++) {
+                if (isPerfect({first, last})) {
+                    return {first, last};
+                }
+            }
+        }
+        return {0, 0};
+    }
+
+    inline constexpr Factors factors = findFactors();
+    static_assert(factors.first != 0, "No collision-free multipliers for the keyword set; grow SIZE");
+
+    // Empty buckets hold an empty word, which never equals a lexeme
+    inline constexpr array<Keyword, SIZE> table = [] {
+        array<Keyword, SIZE> buckets{};
+        for (const Keyword &keyword: keywords) {
+            buckets[bucket(keyword.text, factors)] = keyword;
+        }
+        return buckets;
+    }();
+}
+
+// Returns the keyword's token type, or IDENTIFIER if `word` is not a keyword. `word` must not be empty.
+constexpr TokenType lookupKeyword(const string_view word) {
+    const Keyword &candidate = keyword_hash::table[keyword_hash::bucket(word, keyword_hash::factors)];
+    return candidate.text == word ? candidate.type : TokenType::IDENTIFIER;
+}
+
+static_assert([] {
+    for (const Keyword &keyword: keywords) {
+        if (lookupKeyword(keyword.text) != keyword.type) {
+            return false;
+        }
+    }
+    return lookupKeyword("whale") == TokenType::IDENTIFIER;
+}());
+
+#endif //KEYWORDS_H
@@ -1,8 +1,13 @@
 #include "Lexer.h"
 
+#include <algorithm>
+#include <charconv>
 #include <iostream>
 #include <unordered_map>
 
+#include "Keywords.h"
+#include "Scan.h"
+
 using namespace std;
 
 vector<Token> Lexer::tokenize() {
@@ -26,8 +31,9 @@ vector<Token> Lexer::tokenize() {
 Token Lexer::nextToken() {
     skipWhitespaceAndComments();
     if (isAtEnd()) {
-        return Token{TokenType::EOF_TOKEN, "EndOfFile", line, column};
+        return Token(TokenType::EOF_TOKEN, source.size(), 0);
     }
+    tokenStart = position;
     Token token;
 
     char c = source[position];
@@ -45,24 +51,47 @@ Token Lexer::nextToken() {
     } else {
         // Handle unknown character
         error(string("Unexpected character: ") + c);
-        token = Token{TokenType::UNKNOWN, string(1, c), line, column};
+        token = Token(TokenType::UNKNOWN, position, 1);
     }
     advance();
     return token;
 }
 
+// Errors are raised with the position on the offending character, or at the end for an
+// unterminated string, so everything from the token's start up to and including it is skipped
+Token Lexer::recover() {
+    const size_t end = min(position + 1, source.size());
+    const Token token(TokenType::UNKNOWN, tokenStart, min(end - tokenStart, Token::MAX_LENGTH));
+    skipTo(end);
+    return token;
+}
+
+// Reads past the end yield '\0': a mapped file has no terminator after its last byte
+string_view Lexer::text(const Token &token) const {
+    return source.substr(token.offset, token.length);
+}
+
+SourceLocation Lexer::locate(const size_t offset) const {
+    const auto next = upper_bound(lineStarts.begin(), lineStarts.end(), offset);
+    const auto line = next - lineStarts.begin();
+    return {static_cast<int>(line), static_cast<int>(offset - next[-1]) + 1};
+}
+
+char Lexer::at(const size_t index) const {
+    return index < source.size() ? source[index] : '\0';
+}
+
 char Lexer::peek() const {
-    return source[position];
+    return at(position);
 }
 
 char Lexer::peekNext() {
-    return source[position + 1];
+    return at(position + 1);
 }
 
 char Lexer::advance() {
-    column++;
     position++;
-    return source[position];
+    return at(position);
 }
 
 bool Lexer::isAtEnd() {
@@ -81,39 +110,39 @@ bool Lexer::match(char expected) {
     return true;
 }
 
+// Moves to `end`, recording where each line passed over starts
+void Lexer::skipTo(const size_t end) {
+    const string_view skipped = source.substr(0, end);
+    for (size_t i = scanUntil(skipped, position, '\n'); i < end; i = scanUntil(skipped, i + 1, '\n')) {
+        lineStarts.push_back(static_cast<uint32_t>(i + 1));
+    }
+    position = end;
+}
+
+// Span tokens are limited to Token::MAX_LENGTH bytes and to sources addressable with 32 bits
+Token Lexer::makeToken(const TokenType type, const size_t start, const size_t length) {
+    if (length > Token::MAX_LENGTH || start + length > UINT32_MAX) {
+        error("Token too long or source too large.");
+    }
+    return {type, start, length};
+}
+
 void Lexer::skipWhitespaceAndComments() {
     while (!isAtEnd()) {
         char c = peek();
-        if (isspace(c)) {
-            advance();
-            if (c == '\n') {
-                line++;
-                column = 1;
-            } else {
-                column++;
-            }
+        if (hasClass(c, WHITESPACE)) {
+            skipTo(scanWhitespace(source, position));
         } else if (c == '/') {
             if (peekNext() == '/') {
-                // Single-line comment
-                while (!isAtEnd() && peek() != '\n') {
-                    advance();
-                }
+                // Single-line comment; the newline is left for the whitespace scan
+                position = scanUntil(source, position + 2, '\n');
             } else if (peekNext() == '*') {
-                // Multi-line comment
-                advance(); // Consume '/'
-                advance(); // Consume '*'
-                while (!isAtEnd() && !(peek() == '*' && peekNext() == '/')) {
-                    if (peek() == '\n') {
-                        line++;
-                        column = 1;
-                    }
-                    advance();
-                }
-                // Consume '*/'
-                if (!isAtEnd()) {
-                    advance(); // Consume '*'
-                    advance(); // Consume '/'
+                // Multi-line comment, up to and including '*/' or to the end of input
+                size_t end = scanUntil(source, position + 2, '*');
+                while (end < source.size() && at(end + 1) != '/') {
+                    end = scanUntil(source, end + 1, '*');
                 }
+                skipTo(min(end + 2, source.size()));
             } else {
                 break; // Not a comment
             }
@@ -124,137 +153,109 @@ void Lexer::skipWhitespaceAndComments() {
 }
 
 Token Lexer::identifierOrKeyword(char firstChar) {
-    string lexeme(1, firstChar);
-    while (!isAtEnd() && (isalnum(peekNext()) || peekNext() == '_')) {
-        lexeme += advance();
-    }
-
-    TokenType type = TokenType::IDENTIFIER;
+    const size_t start = position;
+    position = scanIdentifier(source, position + 1) - 1;
+    const string_view lexeme = source.substr(start, position - start + 1);
 
     // Check if lexeme is a keyword
-    auto it = keywordMap.find(lexeme);
-    if (it != keywordMap.end()) {
-        type = it->second;
-    }
-
-    if (lexeme == "let") {
-        return Token{TokenType::LET, lexeme, line, column - static_cast<int>(lexeme.length()) + 1};
-    } else if (lexeme == "const") {
-        return Token{TokenType::CONST, lexeme, line, column - static_cast<int>(lexeme.length()) + 1};
-    } else if (lexeme == "var") {
-        return Token{TokenType::VAR, lexeme, line, column - static_cast<int>(lexeme.length()) + 1};
-    } else {
-        return Token{type, lexeme, line, column - static_cast<int>(lexeme.length()) + 1};
+    Token token = makeToken(lookupKeyword(lexeme), start, lexeme.size());
+    if (token.type == TokenType::IDENTIFIER) {
+        token.symbol = Symbol::intern(lexeme);
     }
+    return token;
 }
 
 bool Lexer::isIdentifierStart(char firstChar) {
-    return isalpha(firstChar) || firstChar == '_';
+    return hasClass(firstChar, IDENTIFIER_START);
 }
 
 Token Lexer::numberLiteral(char firstChar) {
-    string lexeme(1, firstChar);
+    const size_t start = position;
 
-    while (!isAtEnd() && isdigit(peekNext())) {
-        lexeme += advance();
+    while (!isAtEnd() && hasClass(peekNext(), DIGIT)) {
+        advance();
     }
 
-    if (peekNext() == '.' && isdigit(peek())) {
-        lexeme += advance(); // Consume '.'
+    if (peekNext() == '.' && hasClass(peek(), DIGIT)) {
+        advance(); // Consume '.'
 
-        while (!isAtEnd() && isdigit(peekNext())) {
-            lexeme += advance();
+        while (!isAtEnd() && hasClass(peekNext(), DIGIT)) {
+            advance();
         }
     }
 
     // Handle exponential notation
     if (peek() == 'e' || peek() == 'E') {
-        lexeme += advance(); // Consume 'e' or 'E'
+        advance(); // Consume 'e' or 'E'
 
         if (peek() == '+' || peek() == '-') {
-            lexeme += advance();
+            advance();
         }
 
-        while (!isAtEnd() && isdigit(peek())) {
-            lexeme += advance();
+        while (!isAtEnd() && hasClass(peek(), DIGIT)) {
+            advance();
         }
     }
 
-    return Token{TokenType::DOUBLE_LITERAL, lexeme, line, column - static_cast<int>(lexeme.length()) + 1};
+    const string_view lexeme = source.substr(start, position - start + 1);
+
+    // Convert once here, so the parser never re-reads the digits
+    Token token = makeToken(TokenType::DOUBLE_LITERAL, start, lexeme.size());
+    if (from_chars(lexeme.data(), lexeme.data() + lexeme.size(), token.number).ec != errc()) {
+        error("Invalid number literal.");
+    }
+    return token;
 }
 
 bool Lexer::isNumberLiteral(char firstChar) {
-    return isdigit(firstChar);
+    return hasClass(firstChar, DIGIT);
 }
 
 Token Lexer::stringLiteral(char quoteType) {
-    string lexeme;
-    int startColumn = column;
-
-    while (!isAtEnd() && peekNext() != quoteType) {
-        if (peek() == '\\') {
-            advance(); // Consume '\'
-            if (!isAtEnd()) {
-                char escapedChar = advance();
-                lexeme += '\\';
-                lexeme += escapedChar;
-                column += 2;
-            }
-        } else {
-            lexeme += advance();
-        }
+    const size_t start = position + 1; // Skip the opening quote
+
+    // Escapes are kept verbatim, so the lexeme is exactly the source text between the quotes
+    size_t end = scanUntil(source, start, quoteType, '\\');
+    while (end < source.size() && source[end] == '\\') {
+        end = scanUntil(source, end + 2, quoteType, '\\'); // Skip the escaped character
     }
+    const string_view lexeme = source.substr(start, min(end, source.size()) - start);
 
+    // Stop on the closing quote
+    skipTo(min(end, source.size()));
     if (isAtEnd()) {
-        error("Unterminated string literal.");
-        return Token{TokenType::UNKNOWN, lexeme, line, startColumn};
+        // Point at the opening quote, not at the end of the input the string ran into
+        error("Unterminated string literal.", tokenStart, position - tokenStart);
     }
 
-    advance(); // Consume closing quote
-
-    return Token{TokenType::STRING_LITERAL, lexeme, line, startColumn};
+    Token token = makeToken(TokenType::STRING_LITERAL, start, lexeme.size());
+    token.symbol = Symbol::intern(lexeme);
+    return token;
 }
 
 
 Token Lexer::operatorToken(char firstChar) {
-    string lexeme(1, firstChar);
-    int startColumn = column;
-
-    // Check for multi-character operators
-    char nextChar = peekNext();
-    string twoCharOp = lexeme + nextChar;
-
-    if (operatorMap.find(twoCharOp) != operatorMap.end()) {
-        advance(); // Consume nextChar
-        lexeme = twoCharOp;
-    } else if (operatorMap.find(lexeme) == operatorMap.end()) {
-        error("Unknown operator.");
-        return Token{TokenType::UNKNOWN, lexeme, line, startColumn};
+    const size_t start = position;
+
+    // Check for the longest operator first, so `>>>` isn't lexed as `>>` then `>`
+    for (size_t length = 3; length > 0; length--) {
+        const string_view lexeme = source.substr(position, length);
+        if (lexeme.size() != length) {
+            continue;
+        }
+        const auto it = operatorMap.find(lexeme);
+        if (it != operatorMap.end()) {
+            position += length - 1; // Leave position on the operator's last character
+            return makeToken(it->second, start, length);
+        }
     }
 
-    TokenType type = operatorMap[lexeme];
-    return Token{type, lexeme, line, startColumn};
+    error("Unknown operator.");
+    return {};
 }
 
 bool Lexer::isOperatorStart(char firstChar) {
-    switch (firstChar) {
-        case '+':
-        case '-':
-        case '*':
-        case '/':
-        case '%':
-        case '=':
-        case '!':
-        case '<':
-        case '>':
-        case '&':
-        case '|':
-        case '^':
-        case '~':
-            return true;
-        default:
-            return false;
-    }
+    return hasClass(firstChar, OPERATOR_START);
 }
 
 Token Lexer::separatorToken(char c) {
@@ -285,31 +286,22 @@ Token Lexer::separatorToken(char c) {
             break;
         default:
             error("Unknown separator.");
-            return Token{TokenType::UNKNOWN, string(1, c), line, column};
+            return makeToken(TokenType::UNKNOWN, position, 1);
     }
 
-    return Token{type, string(1, c), line, column};
+    return makeToken(type, position, 1);
 }
 
 bool Lexer::isSeparator(char c) {
-    switch (c) {
-        case '(':
-        case ')':
-        case '{':
-        case '}':
-        case '[':
-        case ']':
-        case ',':
-        case ';':
-        case ':':
-        case '.':
-        case '?':
-            return true;
-        default:
-            return false;
-    }
+    return hasClass(c, SEPARATOR);
 }
 
 void Lexer::error(const string &message) {
-    throw runtime_error("Lexer error at line " + to_string(line) + ", column " + to_string(column) + ": " + message);
+    error(message, position, 1);
+}
+
+void Lexer::error(const string &message, const size_t offset, const size_t length) {
+    const SourceLocation location = locate(offset);
+    throw LexerError("Lexer error at line " + to_string(location.line) + ", column " + to_string(location.column) +
+                     ": " + message, message, offset, length);
 }
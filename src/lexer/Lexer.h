@@ -1,33 +1,67 @@
+#ifndef LEXER_H
+#define LEXER_H
+
+#include <stdexcept>
 #include <string>
+#include <string_view>
 #include <unordered_map>
-#include <utility>
 #include <vector>
 
 #include "../../include/Token.h"
 
 using namespace std;
 
+// Thrown by the Lexer; carries where the error is so callers can report it as a diagnostic
+class LexerError : public runtime_error {
+public:
+    LexerError(const string &formatted, string message, const size_t offset, const size_t length)
+        : runtime_error(formatted), message(move(message)), offset(offset), length(length) {
+    }
+
+    string message; // Without the location prefix
+    size_t offset;
+    size_t length; // Of the offending source text
+};
+
+// Tokens refer to spans of the source instead of copying their lexemes, so the buffer passed in
+// (a std::string or a mapped SourceFile) must stay alive as long as the tokens are used.
 class Lexer {
 public:
-    explicit Lexer(string source)
-        : source(move(source)), position(0), line(1), column(1) {
+    explicit Lexer(string_view source)
+        : source(source), position(0), lineStarts{0} {
     }
 
     Token nextToken();
 
+    // After nextToken() threw a LexerError: skips the input that caused it and returns that input
+    // as an UNKNOWN token, so lexing can carry on with whatever follows
+    Token recover();
+
+    // The source text a token was lexed from; for string literals, the text between the quotes
+    string_view text(const Token &token) const;
+
+    // Line and column of an offset the lexer has already passed
+    SourceLocation locate(size_t offset) const;
+
+    SourceLocation locate(const Token &token) const {
+        return locate(token.offset);
+    }
 
     vector<Token> tokenize();
 
 private:
     // Source code
-    string source;
+    string_view source;
     size_t position;
+    size_t tokenStart = 0; // Offset of the token being lexed
 
-    // Current position
-    int line;
-    int column;
+    // Offset of the first byte of every line seen so far, so locations are computed on demand
+    // instead of being stored in each token
+    vector<uint32_t> lineStarts;
 
     // Helper functions
+    char at(size_t index) const;
+
     char peek() const;
 
     char peekNext();
@@ -38,6 +72,10 @@ private:
 
     bool match(char expected);
 
+    void skipTo(size_t end);
+
+    Token makeToken(TokenType type, size_t start, size_t length);
+
     void skipWhitespaceAndComments();
 
     // Token recognition functions
@@ -59,10 +97,12 @@ private:
 
     bool isSeparator(char c);
 
-    // Error handling
+    // Error handling. The error is at the current position unless an offset and length are given.
     void error(const string &message);
 
-    unordered_map<string, TokenType> operatorMap = {
+    void error(const string &message, size_t offset, size_t length);
+
+    unordered_map<string_view, TokenType> operatorMap = {
         // Basic Arithmetic Operators
         {"+", TokenType::PLUS}, {"-", TokenType::MINUS}, {"*", TokenType::MULTIPLY}, {"/", TokenType::DIVIDE}, {"%", TokenType::MODULO},
 
@@ -86,11 +126,6 @@ private:
         {"&", TokenType::BITWISE_AND}, {"|", TokenType::BITWISE_OR}, {"^", TokenType::BITWISE_XOR}, {"~", TokenType::BITWISE_NOT},
         {"<<", TokenType::LEFT_SHIFT}, {">>", TokenType::RIGHT_SHIFT}, {">>>", TokenType::UNSIGNED_RIGHT_SHIFT},
     };
-
-    unordered_map<string, TokenType> keywordMap = {
-        {"if", TokenType::IF}, {"else", TokenType::ELSE}, {"switch", TokenType::SWITCH}, {"case", TokenType::CASE}, {"default", TokenType::DEFAULT},
-        {"for", TokenType::FOR}, {"while", TokenType::WHILE}, {"do", TokenType::DO}, {"break", TokenType::BREAK}, {"continue", TokenType::CONTINUE},
-        {"return", TokenType::RETURN}, {"try", TokenType::TRY}, {"catch", TokenType::CATCH}, {"finally", TokenType::FINALLY},
-        {"throw", TokenType::THROW}, {"new", TokenType::NEW}, {"delete", TokenType::DELETE},
-    };
 };
+
+#endif //LEXER_H
@@ -0,0 +1,180 @@
+#include "Scan.h"
+
+#include <algorithm>
+#include <bit>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#define YOLO_SIMD_SCAN 1
+#endif
+
+using namespace std;
+
+#ifdef YOLO_SIMD_SCAN
+namespace {
+    // One SIMD register of source bytes. Every test returns a bitmask with bit i set when byte i matches.
+    struct Block {
+#ifdef __AVX2__
+        static constexpr size_t WIDTH = 32;
+        __m256i bytes;
+
+        static Block load(const char *data) {
+            return {_mm256_loadu_si256(reinterpret_cast<const __m256i *>(data))};
+        }
+
+        [[nodiscard]] uint32_t equals(const char c) const {
+            return _mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(c)));
+        }
+
+        // Bytes in [low, high], compared unsigned: shift the range down to 0 and test offset <= width
+        [[nodiscard]] uint32_t inRange(const char low, const char high) const {
+            const __m256i offset = _mm256_sub_epi8(bytes, _mm256_set1_epi8(low));
+            const __m256i clamped = _mm256_min_epu8(offset, _mm256_set1_epi8(static_cast<char>(high - low)));
+            return _mm256_movemask_epi8(_mm256_cmpeq_epi8(offset, clamped));
+        }
+
+        [[nodiscard]] uint32_t letters() const {
+            const Block lower{_mm256_or_si256(bytes, _mm256_set1_epi8(0x20))};
+            return lower.inRange('a', 'z');
+        }
+#else
+        static constexpr size_t WIDTH = 16;
+        __m128i bytes;
+
+        static Block load(const char *data) {
+            return {_mm_loadu_si128(reinterpret_cast<const __m128i *>(data))};
+        }
+
+        [[nodiscard]] uint32_t equals(const char c) const {
+            return _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(c)));
+        }
+
+        // Bytes in [low, high], compared unsigned: shift the range down to 0 and test offset <= width
+        [[nodiscard]] uint32_t inRange(const char low, const char high) const {
+            const __m128i offset = _mm_sub_epi8(bytes, _mm_set1_epi8(low));
+            const __m128i clamped = _mm_min_epu8(offset, _mm_set1_epi8(static_cast<char>(high - low)));
+            return _mm_movemask_epi8(_mm_cmpeq_epi8(offset, clamped));
+        }
+
+        [[nodiscard]] uint32_t letters() const {
+            const Block lower{_mm_or_si128(bytes, _mm_set1_epi8(0x20))};
+            return lower.inRange('a', 'z');
+        }
+#endif
+        static constexpr uint32_t ALL = WIDTH == 32 ? 0xFFFFFFFFu : (1u << WIDTH) - 1;
+    };
+
+    // Advances block by block while every byte matches, then returns the first mismatch,
+    // or the start of the tail shorter than a block
+    template<typename Matches>
+    size_t scanBlocksWhile(const string_view text, size_t from, Matches matches) {
+        while (from + Block::WIDTH <= text.size()) {
+            const uint32_t mask = matches(Block::load(text.data() + from));
+            if (mask != Block::ALL) {
+                return from + countr_one(mask);
+            }
+            from += Block::WIDTH;
+        }
+        return from;
+    }
+
+    // Advances block by block until some byte matches, returning its index or the start of the tail
+    template<typename Matches>
+    size_t scanBlocksUntil(const string_view text, size_t from, Matches matches) {
+        while (from + Block::WIDTH <= text.size()) {
+            const uint32_t mask = matches(Block::load(text.data() + from));
+            if (mask != 0) {
+                return from + countr_zero(mask);
+            }
+            from += Block::WIDTH;
+        }
+        return from;
+    }
+
+    // Most runs are a few bytes long (a single space, a short name), so the first SHORT_RUN bytes
+    // are checked one at a time and the block scan only starts for runs longer than that
+    constexpr size_t SHORT_RUN = 16;
+
+    // End of the run of `runClass` bytes starting at `from`; `matches` is the same test on a block
+    template<typename Matches>
+    size_t scanRun(const string_view text, size_t from, const uint8_t runClass, Matches matches) {
+        const size_t shortEnd = min(text.size(), from + SHORT_RUN);
+        while (from < shortEnd && hasClass(text[from], runClass)) {
+            from++;
+        }
+        if (from == shortEnd && from < text.size()) {
+            from = scanBlocksWhile(text, from, matches);
+            while (from < text.size() && hasClass(text[from], runClass)) {
+                from++;
+            }
+        }
+        return from;
+    }
+}
+#endif
+
+size_t scanWhitespace(const string_view text, const size_t from) {
+#ifdef YOLO_SIMD_SCAN
+    return scanRun(text, from, WHITESPACE, [](const Block &block) {
+        return block.equals(' ') | block.inRange('\t', '\r');
+    });
+#else
+    return scanWhitespaceScalar(text, from);
+#endif
+}
+
+size_t scanIdentifier(const string_view text, const size_t from) {
+#ifdef YOLO_SIMD_SCAN
+    return scanRun(text, from, IDENTIFIER_PART, [](const Block &block) {
+        return block.letters() | block.inRange('0', '9') | block.equals('_');
+    });
+#else
+    return scanIdentifierScalar(text, from);
+#endif
+}
+
+size_t scanUntil(const string_view text, size_t from, const char c) {
+#ifdef YOLO_SIMD_SCAN
+    from = scanBlocksUntil(text, from, [c](const Block &block) {
+        return block.equals(c);
+    });
+#endif
+    return scanUntilScalar(text, from, c);
+}
+
+size_t scanUntil(const string_view text, size_t from, const char a, const char b) {
+#ifdef YOLO_SIMD_SCAN
+    from = scanBlocksUntil(text, from, [a, b](const Block &block) {
+        return block.equals(a) | block.equals(b);
+    });
+#endif
+    return scanUntilScalar(text, from, a, b);
+}
+
+size_t scanWhitespaceScalar(const string_view text, size_t from) {
+    while (from < text.size() && hasClass(text[from], WHITESPACE)) {
+        from++;
+    }
+    return from;
+}
+
+size_t scanIdentifierScalar(const string_view text, size_t from) {
+    while (from < text.size() && hasClass(text[from], IDENTIFIER_PART)) {
+        from++;
+    }
+    return from;
+}
+
+size_t scanUntilScalar(const string_view text, size_t from, const char c) {
+    while (from < text.size() && text[from] != c) {
+        from++;
+    }
+    return from;
+}
+
+size_t scanUntilScalar(const string_view text, size_t from, const char a, const char b) {
+    while (from < text.size() && text[from] != a && text[from] != b) {
+        from++;
+    }
+    return from;
+}
@@ -0,0 +1,69 @@
+#ifndef SCAN_H
+#define SCAN_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+using namespace std;
+
+// Character classes for the Lexer, looked up in one table instead of the locale-dependent
+// <cctype> functions. A byte may belong to several classes.
+enum CharClass : uint8_t {
+    WHITESPACE = 1 << 0,
+    IDENTIFIER_START = 1 << 1,
+    IDENTIFIER_PART = 1 << 2,
+    DIGIT = 1 << 3,
+    OPERATOR_START = 1 << 4,
+    SEPARATOR = 1 << 5,
+};
+
+inline constexpr array<uint8_t, 256> charClasses = [] {
+    array<uint8_t, 256> table{};
+    for (const char c: string_view(" \t\n\v\f\r")) {
+        table[static_cast<uint8_t>(c)] |= WHITESPACE;
+    }
+    for (int c = 'a'; c <= 'z'; c++) {
+        table[c] |= IDENTIFIER_START | IDENTIFIER_PART;
+        table[c - 'a' + 'A'] |= IDENTIFIER_START | IDENTIFIER_PART;
+    }
+    table['_'] |= IDENTIFIER_START | IDENTIFIER_PART;
+    for (int c = '0'; c <= '9'; c++) {
+        table[c] |= DIGIT | IDENTIFIER_PART;
+    }
+    for (const char c: string_view("+-*/%=!<>&|^~")) {
+        table[static_cast<uint8_t>(c)] |= OPERATOR_START;
+    }
+    for (const char c: string_view("(){}[],;:.?")) {
+        table[static_cast<uint8_t>(c)] |= SEPARATOR;
+    }
+    return table;
+}();
+
+inline bool hasClass(const char c, const uint8_t classes) {
+    return (charClasses[static_cast<uint8_t>(c)] & classes) != 0;
+}
+
+// Run scanners for the Lexer's hot loops. Each returns the index of the first byte at or after
+// `from` that ends the run, or text.size() if the run reaches the end. They scan a SIMD block
+// (32 bytes with AVX2, 16 with SSE2) at a time and finish the tail with the table.
+size_t scanWhitespace(string_view text, size_t from);
+
+size_t scanIdentifier(string_view text, size_t from);
+
+// First occurrence of `c` (or of either `a` or `b`) at or after `from`
+size_t scanUntil(string_view text, size_t from, char c);
+
+size_t scanUntil(string_view text, size_t from, char a, char b);
+
+// Byte-at-a-time versions, used where no SIMD is available and as the benchmark baseline
+size_t scanWhitespaceScalar(string_view text, size_t from);
+
+size_t scanIdentifierScalar(string_view text, size_t from);
+
+size_t scanUntilScalar(string_view text, size_t from, char c);
+
+size_t scanUntilScalar(string_view text, size_t from, char a, char b);
+
+#endif //SCAN_H
@@ -0,0 +1,68 @@
+#include "SourceFile.h"
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+SourceFile::SourceFile(const string &path) {
+#ifndef _WIN32
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw runtime_error("Could not open file: " + path);
+    }
+    struct stat info{};
+    if (fstat(fd, &info) != 0 || S_ISDIR(info.st_mode)) {
+        close(fd);
+        throw runtime_error("Could not open file: " + path);
+    }
+    // Only a regular file's size is its length: pipes and /proc files report 0, so they are read below
+    const bool regular = S_ISREG(info.st_mode);
+    if (regular && info.st_size > 0) {
+        void *address = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (address != MAP_FAILED) {
+            // The lexer reads front to back exactly once
+            madvise(address, info.st_size, MADV_SEQUENTIAL);
+            data_ = static_cast<const char *>(address);
+            size_ = info.st_size;
+            mapped_ = true;
+        }
+    }
+    close(fd);
+    if (mapped_ || (regular && info.st_size == 0)) {
+        return;
+    }
+#else
+    if (filesystem::is_directory(path)) {
+        throw runtime_error("Could not open file: " + path);
+    }
+#endif
+
+    // Mapping failed or is unsupported, so read the whole file instead
+    ifstream file(path, ios::binary);
+    if (!file) {
+        throw runtime_error("Could not open file: " + path);
+    }
+    stringstream contents;
+    contents << file.rdbuf();
+    buffer_ = contents.str();
+    data_ = buffer_.data();
+    size_ = buffer_.size();
+}
+
+SourceFile::~SourceFile() {
+#ifndef _WIN32
+    if (mapped_) {
+        munmap(const_cast<char *>(data_), size_);
+    }
+#endif
+}
@@ -0,0 +1,37 @@
+#ifndef SOURCEFILE_H
+#define SOURCEFILE_H
+
+#include <string>
+#include <string_view>
+
+using namespace std;
+
+// A script's source text, memory-mapped read-only so the Lexer can slice tokens out of it
+// without copying the file. Falls back to reading into a string where mapping is unavailable.
+class SourceFile {
+public:
+    // Maps the file at `path`; throws runtime_error if it cannot be opened
+    explicit SourceFile(const string &path);
+
+    ~SourceFile();
+
+    SourceFile(const SourceFile &) = delete;
+
+    SourceFile &operator=(const SourceFile &) = delete;
+
+    [[nodiscard]] string_view text() const {
+        return {data_, size_};
+    }
+
+    [[nodiscard]] bool isMapped() const {
+        return mapped_;
+    }
+
+private:
+    const char *data_ = "";
+    size_t size_ = 0;
+    bool mapped_ = false;
+    string buffer_; // Owns the text when the file could not be mapped
+};
+
+#endif //SOURCEFILE_H
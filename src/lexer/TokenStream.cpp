@@ -0,0 +1,48 @@
+#include "TokenStream.h"
+
+
+using namespace std;
+
+TokenStream::TokenStream(Lexer &lexer)
+    : lexer_(lexer) {
+    fill();
+}
+
+const Token &TokenStream::lookahead(const size_t distance) {
+    if (distance > MAX_LOOKAHEAD) {
+        throw out_of_range("Token lookahead is limited to " + to_string(MAX_LOOKAHEAD) + " tokens.");
+    }
+    while (filled_ <= current_ + distance) {
+        fill();
+    }
+    return ring_[(current_ + distance) % CAPACITY];
+}
+
+void TokenStream::advance() {
+    current_++;
+    if (filled_ == current_) {
+        fill();
+    }
+}
+
+// Lexes one more token into the ring. Once the lexer has hit the end, the stream repeats that
+// EOF_TOKEN rather than asking the lexer again.
+void TokenStream::fill() {
+    Token &slot = ring_[filled_ % CAPACITY];
+    if (filled_ > 0 && ring_[(filled_ - 1) % CAPACITY].type == TokenType::EOF_TOKEN) {
+        slot = ring_[(filled_ - 1) % CAPACITY];
+    } else {
+        try {
+            slot = lexer_.nextToken();
+        } catch (const LexerError &e) {
+            // Record the error and carry on after the bad input, so one pass finds every error
+            const SourceLocation location = lexer_.locate(e.offset);
+            diagnostics_.push_back({
+                Diagnostic::Severity::ERROR, location.line, location.column, e.message,
+                static_cast<uint32_t>(e.offset), static_cast<uint32_t>(e.length)
+            });
+            slot = lexer_.recover();
+        }
+    }
+    filled_++;
+}
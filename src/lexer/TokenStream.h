@@ -0,0 +1,71 @@
+#ifndef TOKENSTREAM_H
+#define TOKENSTREAM_H
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+#include "Lexer.h"
+#include "../../include/Token.h"
+#include "../parser/Diagnostic.h"
+
+using namespace std;
+
+// Pull-based view of the Lexer's output for the Parser. Tokens are lexed on demand into a small
+// ring buffer holding the previous token, the current one and a little lookahead, so memory stays
+// constant however long the script is and lexing is interleaved with parsing.
+class TokenStream {
+public:
+    // Number of tokens past the current one that lookahead() can see
+    static constexpr size_t MAX_LOOKAHEAD = 2;
+
+    explicit TokenStream(Lexer &lexer);
+
+    // The current token; always buffered
+    [[nodiscard]] const Token &peek() const {
+        return ring_[current_ % CAPACITY];
+    }
+
+    // The token `distance` places past the current one, lexing it if needed
+    const Token &lookahead(size_t distance);
+
+    // The most recently consumed token; only valid once advance() has been called
+    [[nodiscard]] const Token &previous() const {
+        return ring_[(current_ - 1) % CAPACITY];
+    }
+
+    // Moves to the next token. Past the end the stream keeps returning EOF_TOKEN.
+    void advance();
+
+    // Source text and location of a token from this stream
+    [[nodiscard]] string_view text(const Token &token) const {
+        return lexer_.text(token);
+    }
+
+    [[nodiscard]] SourceLocation locate(const Token &token) const {
+        return lexer_.locate(token);
+    }
+
+    // Lexer errors met so far. The input behind each one comes through as an UNKNOWN token.
+    [[nodiscard]] const vector<Diagnostic> &getDiagnostics() const {
+        return diagnostics_;
+    }
+
+    // Whether the token before the current one was input the Lexer already reported
+    [[nodiscard]] bool afterLexerError() const {
+        return current_ > 0 && previous().type == TokenType::UNKNOWN;
+    }
+
+private:
+    static constexpr size_t CAPACITY = MAX_LOOKAHEAD + 2; // Previous and current tokens plus lookahead
+
+    Lexer &lexer_;
+    array<Token, CAPACITY> ring_;
+    size_t current_ = 0; // Absolute index of the current token
+    size_t filled_ = 0; // Number of tokens pulled from the lexer so far
+    vector<Diagnostic> diagnostics_;
+
+    void fill();
+};
+
+#endif //TOKENSTREAM_H
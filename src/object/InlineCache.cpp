@@ -0,0 +1,105 @@
+#include "InlineCache.h"
+
+#include <stdexcept>
+
+#include "Object.h"
+#include "Shape.h"
+#include "class/Class.h"
+#include "function/Function.h"
+
+// Class method tables are filled when the class is built and never change afterwards, and a
+// field added to an instance changes its Shape, so an entry can never go stale. Entries do not
+// keep their class or method alive, and the collector does not update them; the only classes are
+// the builtin ones, which are permanent, and so are their methods.
+Value InlineCache::get(const Value &receiver, const Symbol name) {
+    if (receiver.isObject()) {
+        const auto object = receiver.asObject();
+        const Shape *shape = object->getShape();
+        const Object *owner = object->classType;
+        for (size_t i = 0; i < size_; i++) {
+            const Entry &entry = entries_[i];
+            if (entry.shape == shape && entry.owner == owner) {
+                return entry.fieldIndex >= 0 ? object->getFieldAt(entry.fieldIndex) : Value(entry.method);
+            }
+        }
+
+        // Check for instance properties
+        if (const int index = shape->indexOf(name); index >= 0) {
+            remember({shape, owner, index, nullptr});
+            return object->getFieldAt(index);
+        }
+        // Check for instance methods
+        if (object->classType) {
+            const auto &methods = object->classType->methods;
+            if (const auto method = methods.find(name); method != methods.end()) {
+                remember({shape, owner, -1, method->second});
+                return Value(method->second);
+            }
+        }
+    } else if (receiver.isClass()) {
+        const auto classObject = receiver.asClass();
+        for (size_t i = 0; i < size_; i++) {
+            const Entry &entry = entries_[i];
+            if (entry.shape == nullptr && entry.owner == classObject) {
+                return Value(entry.method);
+            }
+        }
+
+        // Check for static methods
+        if (const auto method = classObject->staticMethods.find(name); method != classObject->staticMethods.end()) {
+            remember({nullptr, classObject, -1, method->second});
+            return Value(method->second);
+        }
+    }
+
+    return lookup(receiver, name);
+}
+
+Value InlineCache::lookup(const Value &receiver, const Symbol name) {
+    if (receiver.isClass()) {
+        const auto classObject = receiver.asClass();
+        // Check for static methods
+        if (const auto method = classObject->staticMethods.find(name); method != classObject->staticMethods.end()) {
+            return Value(method->second);
+        }
+        // Check for static properties
+        if (const auto property = classObject->staticProperties.find(name);
+            property != classObject->staticProperties.end()) {
+            return property->second;
+        }
+    } else if (receiver.isFunction()) {
+        const auto functionObject = receiver.asFunction();
+        // Check for properties on the function object
+        if (const auto property = functionObject->properties.find(name); property != functionObject->properties.end()) {
+            return property->second;
+        }
+    } else if (receiver.isObject()) {
+        const auto object = receiver.asObject();
+        // Check for instance properties
+        if (const auto field = object->getField(name)) {
+            return *field;
+        }
+        // Check for instance methods
+        if (object->classType) {
+            const auto &methods = object->classType->methods;
+            if (const auto method = methods.find(name); method != methods.end()) {
+                return Value(method->second);
+            }
+        }
+    } else {
+        throw std::runtime_error("Only objects, classes, and functions have properties.");
+    }
+
+    throw std::runtime_error("Undefined property '" + name.str() + "'.");
+}
+
+void InlineCache::remember(Entry entry) {
+    if (megamorphic_) {
+        return;
+    }
+    if (size_ == MAX_ENTRIES) {
+        megamorphic_ = true;
+        return;
+    }
+    entries_[size_++] = std::move(entry);
+}
@@ -0,0 +1,50 @@
+#ifndef INLINECACHE_H
+#define INLINECACHE_H
+
+#include <array>
+#include <cstdint>
+#include <memory>
+
+#include "value/Value.h"
+#include "../../include/Symbol.h"
+
+class Function;
+class Object;
+class Shape;
+
+// Per-site cache for `object.name` lookups. Each entry remembers where the property was
+// found for one receiver layout, so a repeated access such as `arr.push` in a loop costs a
+// Shape and class compare plus an indexed load instead of hash lookups.
+//
+// Up to MAX_ENTRIES receiver layouts are cached (polymorphic); a site that sees more goes
+// megamorphic and always takes the uncached path.
+class InlineCache {
+public:
+    static constexpr size_t MAX_ENTRIES = 4;
+
+    // Resolves `receiver.name`, consulting and filling the cache
+    Value get(const Value &receiver, Symbol name);
+
+    // Uncached property lookup, shared by every access site
+    static Value lookup(const Value &receiver, Symbol name);
+
+    [[nodiscard]] bool isMegamorphic() const {
+        return megamorphic_;
+    }
+
+private:
+    struct Entry {
+        const Shape *shape; // Receiver layout; nullptr when the receiver is a class
+        const Object *owner; // Class of an instance receiver, or the class receiver itself
+        int fieldIndex; // >= 0: load this slot of the receiver
+        Function *method; // Otherwise: the method found on owner
+    };
+
+    std::array<Entry, MAX_ENTRIES> entries_{};
+    uint8_t size_ = 0;
+    bool megamorphic_ = false;
+
+    void remember(Entry entry);
+};
+
+#endif // INLINECACHE_H
@@ -1,2 +1,28 @@
 #include "Object.h"
 #include <stdexcept>
+
+#include "class/Class.h"
+
+const Value *Object::getField(const Symbol name) const {
+    const int index = shape_->indexOf(name);
+    return index >= 0 ? &slots_[index] : nullptr;
+}
+
+void Object::setField(const Symbol name, Value value) {
+    const int index = shape_->indexOf(name);
+    if (index >= 0) {
+        Heap::writeBarrier(this, slots_[index], value);
+        slots_[index] = std::move(value);
+        return;
+    }
+    Heap::writeBarrier(this, value);
+    shape_ = shape_->withField(name);
+    slots_.push_back(std::move(value));
+}
+
+void Object::trace(Heap &heap) {
+    heap.mark(classType);
+    for (Value &value: slots_) {
+        heap.mark(value);
+    }
+}
@@ -1,20 +1,43 @@
 #ifndef OBJECT_H
 #define OBJECT_H
 
-#include <map>
 #include <string>
 #include <memory>
+#include <vector>
+
+#include "Shape.h"
+#include "gc/Heap.h"
+#include "value/Value.h"
+#include "../../include/Symbol.h"
 
 class Class;
-class Value; // Forward declaration
 
-class Object {
+// Objects are owned by the garbage collector: allocate them with Heap::allocate, never with new
+class Object : public GcObject {
 public:
-    virtual ~Object() = default;
+    // Returns the field's value, or nullptr if the object has no such field
+    [[nodiscard]] const Value *getField(Symbol name) const;
+
+    // Overwrites an existing field in place; a new field moves the object to the next Shape
+    void setField(Symbol name, Value value);
+
+    [[nodiscard]] const Shape *getShape() const {
+        return shape_;
+    }
+
+    // Indexed load for callers that already resolved `index` against getShape()
+    [[nodiscard]] const Value &getFieldAt(const size_t index) const {
+        return slots_[index];
+    }
+
+    // Marks the class and the field values; subclasses add what they hold
+    void trace(Heap &heap) override;
 
-    std::map<std::string, std::shared_ptr<Value> > fields;
+    Class *classType = nullptr;
 
-    std::shared_ptr<Class> classType;
+private:
+    Shape *shape_ = Shape::root();
+    std::vector<Value> slots_;
 };
 
 #endif // OBJECT_H
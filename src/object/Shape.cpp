@@ -0,0 +1,50 @@
+#include "Shape.h"
+
+Shape::Shape(Shape *parent, const Symbol name)
+    : parent_(parent), name_(name), fieldCount_(parent->fieldCount_ + 1) {
+}
+
+Shape *Shape::root() {
+    static Shape root;
+    return &root;
+}
+
+Shape *Shape::withField(const Symbol name) {
+    auto &next = transitions_[name];
+    if (!next) {
+        next.reset(new Shape(this, name));
+    }
+    return next.get();
+}
+
+int Shape::indexOf(const Symbol name) const {
+    if (fieldCount_ <= LINEAR_SEARCH_LIMIT) {
+        for (const Shape *shape = this; shape->parent_; shape = shape->parent_) {
+            if (shape->name_ == name) {
+                return static_cast<int>(shape->fieldCount_ - 1);
+            }
+        }
+        return -1;
+    }
+    const Table &fields = table();
+    const auto it = fields.indices.find(name);
+    return it != fields.indices.end() && it->second < static_cast<int>(fieldCount_) ? it->second : -1;
+}
+
+// An object gains its fields one at a time and is looked up at every step, so the parent's table
+// usually ends at the parent and can simply be extended; only a branch in the tree copies one
+const Shape::Table &Shape::table() const {
+    if (!table_) {
+        if (parent_->table_ && parent_->table_->owner == parent_) {
+            table_ = parent_->table_;
+            table_->indices.emplace(name_, static_cast<int>(fieldCount_ - 1));
+        } else {
+            table_ = make_shared<Table>();
+            for (const Shape *shape = this; shape->parent_; shape = shape->parent_) {
+                table_->indices.emplace(shape->name_, static_cast<int>(shape->fieldCount_ - 1));
+            }
+        }
+        table_->owner = this;
+    }
+    return *table_;
+}
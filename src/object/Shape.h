@@ -0,0 +1,55 @@
+#ifndef SHAPE_H
+#define SHAPE_H
+
+#include <memory>
+#include <unordered_map>
+
+#include "../../include/Symbol.h"
+
+// Hidden class describing the field layout of an Object. Objects that gained the same
+// fields in the same order share one Shape, so a field lookup that was resolved once for a
+// Shape can be replayed as a pointer compare plus an indexed load.
+//
+// Shapes form a transition tree rooted at root(); they are never freed. Each Shape only records
+// the field it added and points at its parent, so a chain of n fields takes O(n) memory.
+class Shape {
+public:
+    // The empty layout every new Object starts with
+    static Shape *root();
+
+    // The Shape reached by appending `name` to this layout, created on first use
+    Shape *withField(Symbol name);
+
+    // Slot index of `name`, or -1 if this layout has no such field
+    [[nodiscard]] int indexOf(Symbol name) const;
+
+    [[nodiscard]] size_t fieldCount() const {
+        return fieldCount_;
+    }
+
+private:
+    // Layouts up to this many fields are searched by walking the chain
+    static constexpr size_t LINEAR_SEARCH_LIMIT = 8;
+
+    // Field indices of one path through the tree, shared by the Shapes along it. It holds the
+    // fields of `owner` and its ancestors; a Shape on the path ignores entries at or past its
+    // fieldCount_, which belong to its descendants.
+    struct Table {
+        unordered_map<Symbol, int> indices;
+        const Shape *owner;
+    };
+
+    Shape *parent_ = nullptr;
+    Symbol name_; // The field this Shape added; unused on the root
+    size_t fieldCount_ = 0;
+    unordered_map<Symbol, unique_ptr<Shape> > transitions_;
+    mutable shared_ptr<Table> table_; // Built on the first lookup past LINEAR_SEARCH_LIMIT
+
+    Shape() = default;
+
+    Shape(Shape *parent, Symbol name);
+
+    const Table &table() const;
+};
+
+#endif // SHAPE_H
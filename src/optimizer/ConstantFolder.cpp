@@ -0,0 +1,290 @@
+#include "ConstantFolder.h"
+
+#include <stdexcept>
+
+#include "ast/AST.h"
+#include "interpreter/Operators.h"
+
+using namespace std;
+
+namespace {
+    // Counts the nodes of a tree, so the pass can report what it removed
+    class NodeCounter : public Visitor {
+    public:
+        size_t count = 0;
+
+        Value visitLiteralExpression(LiteralExpression *expression) override {
+            count++;
+            return {};
+        }
+
+        Value visitIdentifierExpression(IdentifierExpression *expression) override {
+            count++;
+            return {};
+        }
+
+        Value visitBinaryExpression(BinaryExpression *expression) override {
+            count++;
+            expression->getLeft()->accept(*this);
+            expression->getRight()->accept(*this);
+            return {};
+        }
+
+        Value visitUnaryExpression(UnaryExpression *expression) override {
+            count++;
+            expression->getRight()->accept(*this);
+            return {};
+        }
+
+        Value visitAssignmentExpression(AssignmentExpression *expression) override {
+            count++;
+            expression->getValue()->accept(*this);
+            return {};
+        }
+
+        Value visitLogicalExpression(LogicalExpression *expression) override {
+            count++;
+            expression->getLeft()->accept(*this);
+            expression->getRight()->accept(*this);
+            return {};
+        }
+
+        Value visitFunctionCallExpression(FunctionCallExpression *expression) override {
+            count++;
+            expression->getCallee()->accept(*this);
+            for (const auto &argument: expression->getArguments()) {
+                argument->accept(*this);
+            }
+            return {};
+        }
+
+        Value visitGetExpression(GetExpression *expression) override {
+            count++;
+            expression->getObject()->accept(*this);
+            return {};
+        }
+
+        void visitExpressionStatement(ExpressionStatement *statement) override {
+            count++;
+            statement->getExpression()->accept(*this);
+        }
+
+        void visitVariableDeclaration(VariableDeclaration *statement) override {
+            count++;
+            if (statement->hasInitializer()) {
+                statement->getInitializer()->accept(*this);
+            }
+        }
+
+        void visitBlockStatement(BlockStatement *statement) override {
+            count++;
+            for (const auto &inner: statement->getStatements()) {
+                if (inner) {
+                    inner->accept(*this);
+                }
+            }
+        }
+
+        void visitIfStatement(IfStatement *statement) override {
+            count++;
+            statement->getCondition()->accept(*this);
+            statement->getThenBranch()->accept(*this);
+            if (statement->getElseBranch()) {
+                statement->getElseBranch()->accept(*this);
+            }
+        }
+
+        void visitWhileStatement(WhileStatement *statement) override {
+            count++;
+            statement->getCondition()->accept(*this);
+            statement->getBody()->accept(*this);
+        }
+
+        void visitReturnStatement(ReturnStatement *statement) override {
+            count++;
+            if (statement->getValue()) {
+                statement->getValue()->accept(*this);
+            }
+        }
+
+        void visitFunctionDeclaration(FunctionDeclaration *statement) override {
+            count++;
+            statement->getBody()->accept(*this);
+        }
+    };
+
+    size_t countNodes(const vector<unique_ptr<Statement> > &statements) {
+        NodeCounter counter;
+        for (const auto &statement: statements) {
+            if (statement) {
+                statement->accept(counter);
+            }
+        }
+        return counter.count;
+    }
+
+    // Evaluates an operator on constants, or returns nothing if it would throw at runtime
+    template<typename Apply>
+    optional<Value> evaluate(Apply apply) {
+        try {
+            return apply();
+        } catch (const runtime_error &) {
+            return nullopt;
+        }
+    }
+}
+
+size_t ConstantFolder::fold(CompilationUnit &unit) {
+    Arena::Scope scope(unit.arena);
+    const size_t before = countNodes(unit.statements);
+    fold(unit.statements);
+    return before - countNodes(unit.statements);
+}
+
+optional<Value> ConstantFolder::fold(unique_ptr<Expression> &slot) {
+    const Value value = slot->accept(*this);
+    if (!constant_) {
+        return nullopt;
+    }
+    if (!dynamic_cast<LiteralExpression *>(slot.get())) {
+        slot = make_unique<LiteralExpression>(value.getType(), value);
+    }
+    return value;
+}
+
+Value ConstantFolder::result(const optional<Value> &value) {
+    constant_ = value.has_value();
+    return value.value_or(Value());
+}
+
+void ConstantFolder::fold(unique_ptr<Statement> &slot) {
+    replaced_ = false;
+    slot->accept(*this);
+    if (replaced_) {
+        replaced_ = false;
+        slot = move(replacement_);
+    }
+}
+
+void ConstantFolder::foldBranch(unique_ptr<Statement> &slot) {
+    fold(slot);
+    if (!slot) {
+        slot = make_unique<BlockStatement>(vector<unique_ptr<Statement> >());
+    }
+}
+
+void ConstantFolder::fold(vector<unique_ptr<Statement> > &statements) {
+    for (unique_ptr<Statement> &statement: statements) {
+        if (statement) {
+            fold(statement);
+        }
+    }
+    erase(statements, nullptr);
+}
+
+Value ConstantFolder::visitLiteralExpression(LiteralExpression *expression) {
+    return result(expression->getValue());
+}
+
+Value ConstantFolder::visitIdentifierExpression(IdentifierExpression *expression) {
+    return result(nullopt);
+}
+
+Value ConstantFolder::visitBinaryExpression(BinaryExpression *expression) {
+    const optional<Value> left = fold(expression->left_);
+    const optional<Value> right = fold(expression->right_);
+    if (!left || !right) {
+        return result(nullopt);
+    }
+    return result(evaluate([&] { return applyBinary(expression->getOperator(), *left, *right); }));
+}
+
+Value ConstantFolder::visitUnaryExpression(UnaryExpression *expression) {
+    const optional<Value> right = fold(expression->right_);
+    if (!right) {
+        return result(nullopt);
+    }
+    return result(evaluate([&] { return applyUnary(expression->getOperator(), *right); }));
+}
+
+Value ConstantFolder::visitAssignmentExpression(AssignmentExpression *expression) {
+    fold(expression->value_);
+    return result(nullopt);
+}
+
+// The result is the truthiness of the operand that decides it, so a constant left operand that
+// short-circuits decides it alone, whatever the right operand is
+Value ConstantFolder::visitLogicalExpression(LogicalExpression *expression) {
+    const optional<Value> left = fold(expression->left_);
+    const optional<Value> right = fold(expression->right_);
+    if (!left) {
+        return result(nullopt);
+    }
+    const bool isAnd = expression->getOperator() == LogicalExpression::Operator::And;
+    if (left->isTruthy() != isAnd) {
+        return result(Value(left->isTruthy()));
+    }
+    return result(right ? optional(Value(right->isTruthy())) : nullopt);
+}
+
+Value ConstantFolder::visitFunctionCallExpression(FunctionCallExpression *expression) {
+    fold(expression->callee_);
+    for (unique_ptr<Expression> &argument: expression->arguments_) {
+        fold(argument);
+    }
+    return result(nullopt);
+}
+
+Value ConstantFolder::visitGetExpression(GetExpression *expression) {
+    fold(expression->object_);
+    return result(nullopt);
+}
+
+void ConstantFolder::visitExpressionStatement(ExpressionStatement *statement) {
+    fold(statement->expression_);
+}
+
+void ConstantFolder::visitVariableDeclaration(VariableDeclaration *statement) {
+    if (statement->hasInitializer()) {
+        fold(statement->initializer_);
+    }
+}
+
+void ConstantFolder::visitBlockStatement(BlockStatement *statement) {
+    fold(statement->statements_);
+}
+
+// A constant condition leaves only the branch that runs, or nothing if that is a missing else
+void ConstantFolder::visitIfStatement(IfStatement *statement) {
+    const optional<Value> condition = fold(statement->condition_);
+    foldBranch(statement->thenBranch_);
+    if (statement->elseBranch_) {
+        foldBranch(statement->elseBranch_);
+    }
+
+    if (condition) {
+        replacement_ = condition->isTruthy() ? move(statement->thenBranch_) : move(statement->elseBranch_);
+        replaced_ = true;
+    }
+}
+
+// A loop whose condition is constantly false never runs. One that is constantly true is kept.
+void ConstantFolder::visitWhileStatement(WhileStatement *statement) {
+    const optional<Value> condition = fold(statement->condition_);
+    foldBranch(statement->body_);
+
+    if (condition && !condition->isTruthy()) {
+        replacement_ = nullptr;
+        replaced_ = true;
+    }
+}
+
+void ConstantFolder::visitReturnStatement(ReturnStatement *statement) {
+    if (statement->value_) {
+        fold(statement->value_);
+    }
+}
+
+void ConstantFolder::visitFunctionDeclaration(FunctionDeclaration *statement) {
+    visitBlockStatement(statement->getBody());
+}
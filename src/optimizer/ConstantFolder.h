@@ -0,0 +1,81 @@
+#ifndef CONSTANTFOLDER_H
+#define CONSTANTFOLDER_H
+
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "../visitor/Visitor.h"
+#include "ast/CompilationUnit.h"
+
+// Optimization pass run between the Parser and the Resolver. Operators whose operands are all
+// literals are evaluated once, with the Interpreter's own operator functions, and replaced by a
+// LiteralExpression; if and while statements whose condition folds to a constant lose the branch
+// that can never run. Operations that would fail (division by zero, a string operand to `-`) are
+// left alone so they still fail at runtime.
+//
+// Expression visits return the folded value of a constant expression and set constant_ to say
+// whether there was one.
+class ConstantFolder : public Visitor {
+public:
+    // Folds the unit in place, allocating new nodes from its arena. Returns how many nodes were removed.
+    size_t fold(CompilationUnit &unit);
+
+    // Visitor methods for expressions
+    Value visitLiteralExpression(LiteralExpression *expression) override;
+
+    Value visitIdentifierExpression(IdentifierExpression *expression) override;
+
+    Value visitBinaryExpression(BinaryExpression *expression) override;
+
+    Value visitUnaryExpression(UnaryExpression *expression) override;
+
+    Value visitAssignmentExpression(AssignmentExpression *expression) override;
+
+    Value visitLogicalExpression(LogicalExpression *expression) override;
+
+    Value visitFunctionCallExpression(FunctionCallExpression *expression) override;
+
+    Value visitGetExpression(GetExpression *expression) override;
+
+    // Visitor methods for statements
+    void visitExpressionStatement(ExpressionStatement *statement) override;
+
+    void visitVariableDeclaration(VariableDeclaration *statement) override;
+
+    void visitBlockStatement(BlockStatement *statement) override;
+
+    void visitIfStatement(IfStatement *statement) override;
+
+    void visitWhileStatement(WhileStatement *statement) override;
+
+    void visitReturnStatement(ReturnStatement *statement) override;
+
+    void visitFunctionDeclaration(FunctionDeclaration *statement) override;
+
+private:
+    // Set by a statement visit that wants its statement replaced by `replacement_`, or removed if that is null
+    bool replaced_ = false;
+    unique_ptr<Statement> replacement_;
+
+    // Set by every expression visit: whether the value it returned is the expression's constant value
+    bool constant_ = false;
+
+    // Folds the expression in `slot`, replacing it by a literal if it is constant; returns its value if so
+    optional<Value> fold(unique_ptr<Expression> &slot);
+
+    // Ends an expression visit, recording whether it found a constant
+    Value result(const optional<Value> &value);
+
+    // Folds the statement in `slot`, which becomes null if the statement was removed
+    void fold(unique_ptr<Statement> &slot);
+
+    // As above, but a removed statement is replaced by an empty block where a statement is required
+    void foldBranch(unique_ptr<Statement> &slot);
+
+    // Folds a statement list, dropping removed statements
+    void fold(vector<unique_ptr<Statement> > &statements);
+};
+
+#endif //CONSTANTFOLDER_H
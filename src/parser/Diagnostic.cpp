@@ -0,0 +1,18 @@
+#include "Diagnostic.h"
+
+using namespace std;
+
+string Diagnostic::format(const string_view source) const {
+    string text = "[Line " + to_string(line) + ", Column " + to_string(column) + "] ";
+    text += severity == Severity::ERROR ? "Error" : "Warning";
+    if (length == 0) {
+        text += " at end";
+    } else {
+        // A span running over several lines, like an unterminated string, is shown up to its first line break
+        const string_view span = source.substr(offset, length);
+        text += " at '";
+        text += span.substr(0, span.find('\n'));
+        text += "'";
+    }
+    return text + ": " + message;
+}
@@ -0,0 +1,27 @@
+#ifndef DIAGNOSTIC_H
+#define DIAGNOSTIC_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+using namespace std;
+
+// A problem found while lexing or parsing, recorded instead of thrown so that one pass over a
+// file reports every error in it. The span is the offending token's; an empty span means the
+// error is at the end of the input.
+struct Diagnostic {
+    enum class Severity { ERROR, WARNING };
+
+    Severity severity;
+    int line;
+    int column;
+    string message;
+    uint32_t offset; // Span of the offending token in the source
+    uint32_t length;
+
+    // Formats as "[Line 3, Column 7] Error at 'x': message", quoting the span from `source`
+    [[nodiscard]] string format(string_view source) const;
+};
+
+#endif //DIAGNOSTIC_H
@@ -1,8 +1,10 @@
 #include "Parser.h"
+
+#include <algorithm>
 #include <iostream>
 
-Parser::Parser(const vector<Token> &tokens)
-    : tokens_(tokens), current_(0) {
+Parser::Parser(TokenStream &tokens)
+    : tokens_(tokens) {
 }
 
 vector<unique_ptr<Statement> > Parser::parse() {
@@ -16,6 +18,21 @@ vector<unique_ptr<Statement> > Parser::parse() {
     return statements;
 }
 
+void Parser::parseInto(CompilationUnit &unit) {
+    Arena::Scope scope(unit.arena);
+    unit.statements = parse();
+
+    unit.diagnostics = tokens_.getDiagnostics();
+    unit.diagnostics.insert(unit.diagnostics.end(), diagnostics_.begin(), diagnostics_.end());
+    stable_sort(unit.diagnostics.begin(), unit.diagnostics.end(), [](const Diagnostic &a, const Diagnostic &b) {
+        return a.offset < b.offset;
+    });
+}
+
+const vector<Diagnostic> &Parser::getDiagnostics() const {
+    return diagnostics_;
+}
+
 // Helper Methods
 
 bool Parser::isAtEnd() const {
@@ -23,15 +40,15 @@ bool Parser::isAtEnd() const {
 }
 
 const Token &Parser::peek() const {
-    return tokens_[current_];
+    return tokens_.peek();
 }
 
 const Token &Parser::previous() const {
-    return tokens_[current_ - 1];
+    return tokens_.previous();
 }
 
 const Token &Parser::advance() {
-    if (!isAtEnd()) current_++;
+    if (!isAtEnd()) tokens_.advance();
     return previous();
 }
 
@@ -40,7 +57,7 @@ bool Parser::check(TokenType type) const {
     return peek().type == type;
 }
 
-bool Parser::match(const vector<TokenType> &types) {
+bool Parser::match(const initializer_list<TokenType> types) {
     for (TokenType type: types) {
         if (check(type)) {
             advance();
@@ -50,28 +67,35 @@ bool Parser::match(const vector<TokenType> &types) {
     return false;
 }
 
+// On a mismatch this records the error and returns a stand-in token of the expected type, with
+// an empty name, so the caller can finish building its (discarded) node
 Token Parser::consume(TokenType type, const string &errorMessage) {
     if (check(type)) return advance();
     error(peek(), errorMessage);
-    throw runtime_error("Parsing Error"); // Exception handling
+    Token missing(type, peek().offset, 0);
+    missing.symbol = Symbol();
+    return missing;
 }
 
 // Parsing Methods
 
 unique_ptr<Statement> Parser::declaration() {
-    try {
-        if (match({TokenType::VAR, TokenType::LET, TokenType::CONST})) {
-            return variableDeclaration();
-        } else if (match({TokenType::FUNCTION})) {
-            return functionDeclaration();
-        } else {
-            return statement();
-        }
-    } catch (const runtime_error &) {
-        cout << "Parser Error" << endl;
-        synchronize();
+    const uint32_t start = peek().offset;
+    unique_ptr<Statement> declaration;
+    if (match({TokenType::VAR, TokenType::LET, TokenType::CONST})) {
+        declaration = variableDeclaration();
+    } else if (match({TokenType::FUNCTION})) {
+        declaration = functionDeclaration();
+    } else {
+        declaration = statement();
+    }
+
+    // Drop a declaration that had an error and skip to where the next one likely starts
+    if (panicking_) {
+        synchronize(start);
         return nullptr;
     }
+    return declaration;
 }
 
 unique_ptr<Statement> Parser::variableDeclaration() {
@@ -81,7 +105,7 @@ unique_ptr<Statement> Parser::variableDeclaration() {
     string typeName = varType == TokenType::CONST ? "const" : "let"; // Default type (can be adjusted as needed)
     if (match({TokenType::COLON})) {
         Token typeToken = consume(TokenType::IDENTIFIER, "Expected type name.");
-        typeName = typeToken.value;
+        typeName = typeToken.symbol.str();
     }
 
     unique_ptr<Expression> initializer;
@@ -90,7 +114,7 @@ unique_ptr<Statement> Parser::variableDeclaration() {
     }
 
     consume(TokenType::SEMICOLON, "Expected ';' after variable declaration.");
-    return make_unique<VariableDeclaration>(name.value, typeName, move(initializer));
+    return make_unique<VariableDeclaration>(name.symbol, typeName, move(initializer));
 }
 
 unique_ptr<Statement> Parser::functionDeclaration() {
@@ -105,9 +129,9 @@ unique_ptr<Statement> Parser::functionDeclaration() {
             string paramTypeName = "var"; // Default parameter type
             if (match({TokenType::COLON})) {
                 Token paramType = consume(TokenType::IDENTIFIER, "Expected parameter type.");
-                paramTypeName = paramType.value;
+                paramTypeName = paramType.symbol.str();
             }
-            parameters.push_back({paramName.value, paramTypeName});
+            parameters.push_back({paramName.symbol, paramTypeName});
         } while (match({TokenType::COMMA}));
     }
 
@@ -116,14 +140,14 @@ unique_ptr<Statement> Parser::functionDeclaration() {
     string returnTypeName = "void";
     if (match({TokenType::COLON})) {
         Token returnType = consume(TokenType::IDENTIFIER, "Expected return type.");
-        returnTypeName = returnType.value;
+        returnTypeName = returnType.symbol.str();
     }
 
     consume(TokenType::LEFT_BRACE, "Expected '{' before function body.");
 
     auto body = unique_ptr<BlockStatement>(static_cast<BlockStatement *>(blockStatement().release()));
 
-    return make_unique<FunctionDeclaration>(name.value, parameters, returnTypeName, move(body));
+    return make_unique<FunctionDeclaration>(name.symbol, parameters, returnTypeName, move(body));
 }
 
 unique_ptr<Statement> Parser::statement() {
@@ -200,7 +224,7 @@ unique_ptr<Statement> Parser::forStatement() {
     }
 
     if (!condition) {
-        condition = make_unique<LiteralExpression>(TokenType::BOOLEAN_LITERAL, make_shared<BoolValue>(true));
+        condition = make_unique<LiteralExpression>(TokenType::BOOLEAN_LITERAL, Value(true));
     }
 
     body = make_unique<WhileStatement>(move(condition), move(body));
@@ -242,225 +266,198 @@ unique_ptr<Statement> Parser::expressionStatement() {
     return make_unique<ExpressionStatement>(move(expr));
 }
 
-unique_ptr<Expression> Parser::expression() {
-    return assignment();
-}
-
-unique_ptr<Expression> Parser::assignment() {
-    auto expr = logicalOr(); // Parse a higher-precedence expression first
-
-    if (match({
-        TokenType::ASSIGN, TokenType::PLUS_ASSIGN, TokenType::MINUS_ASSIGN, TokenType::MULTIPLY_ASSIGN,
-        TokenType::DIVIDE_ASSIGN, TokenType::MODULO_ASSIGN
-    })) {
-        Token op = previous(); // The assignment operator token
-        auto value = assignment(); // Recursively parse the right-hand side
-
-        // Check if the left-hand side is a valid assignment target
-        if (auto varExpr = dynamic_cast<IdentifierExpression *>(expr.get())) {
-            string name = varExpr->getName();
-
-            // If it's a compound assignment, we need to apply the binary operation
-            if (op.type != TokenType::ASSIGN) {
-                // Create a binary expression: `a += b` becomes `a = a + b`
-                BinaryExpression::Operator binaryOp;
-                switch (op.type) {
-                    case TokenType::PLUS_ASSIGN:
-                        binaryOp = BinaryExpression::Operator::ADD;
-                        break;
-                    case TokenType::MINUS_ASSIGN:
-                        binaryOp = BinaryExpression::Operator::SUBTRACT;
-                        break;
-                    case TokenType::MULTIPLY_ASSIGN:
-                        binaryOp = BinaryExpression::Operator::MULTIPLY;
-                        break;
-                    case TokenType::DIVIDE_ASSIGN:
-                        binaryOp = BinaryExpression::Operator::DIVIDE;
-                        break;
-                    case TokenType::MODULO_ASSIGN:
-                        binaryOp = BinaryExpression::Operator::MODULO;
-                        break;
-                    default:
-                        binaryOp = BinaryExpression::Operator::UNKNOWN;
-                        break;
-                }
-
-                // Create the binary expression `a + b`, `a - b`, etc.
-                auto binaryExpr = make_unique<BinaryExpression>(make_unique<IdentifierExpression>(name),
-                                                                // Left-hand side (`a`)
-                                                                binaryOp, // Operator (`+`, `-`, etc.)
-                                                                move(value) // Right-hand side (`b`)
-                );
-
-                // Now return an assignment expression: `a = a + b`
-                return make_unique<AssignmentExpression>(name, move(binaryExpr), TokenType::ASSIGN);
-            }
-
-            // If it's a simple assignment, return it as is
-            return make_unique<AssignmentExpression>(name, move(value), op.type);
-        } else {
-            error(op, "Invalid assignment target.");
-        }
-    }
-
-    return expr; // If no assignment, return the original expression
+// Expressions are parsed by precedence climbing (Pratt parsing): every token type has a rule
+// saying how it starts an expression (prefix), how it continues one (infix) and how tightly it
+// binds as an infix operator. One loop handles every binary level, so parsing an operand costs a
+// table lookup instead of a call through each level of a precedence cascade.
+
+const Parser::ParseRule &Parser::getRule(const TokenType type) {
+    static constexpr array<ParseRule, static_cast<size_t>(TokenType::UNKNOWN) + 1> rules = [] {
+        array<ParseRule, static_cast<size_t>(TokenType::UNKNOWN) + 1> table{};
+        const auto prefix = [&table](const TokenType type, const PrefixRule rule) {
+            table[static_cast<size_t>(type)].prefix = rule;
+        };
+        const auto infix = [&table](const TokenType type, const InfixRule rule, const Precedence precedence,
+                                    const BinaryExpression::Operator op = BinaryExpression::Operator::UNKNOWN) {
+            ParseRule &entry = table[static_cast<size_t>(type)];
+            entry.infix = rule;
+            entry.precedence = precedence;
+            entry.op = op;
+        };
+
+        prefix(TokenType::DOUBLE_LITERAL, &Parser::literal);
+        prefix(TokenType::STRING_LITERAL, &Parser::literal);
+        prefix(TokenType::BOOLEAN_LITERAL, &Parser::literal);
+        prefix(TokenType::NULL_LITERAL, &Parser::literal);
+        prefix(TokenType::IDENTIFIER, &Parser::identifier);
+        prefix(TokenType::LEFT_PAREN, &Parser::grouping);
+        prefix(TokenType::MINUS, &Parser::unary);
+        prefix(TokenType::LOGICAL_NOT, &Parser::unary);
+        prefix(TokenType::BITWISE_NOT, &Parser::unary);
+
+        // Compound assignments carry the operator they apply: `a += b` becomes `a = a + b`
+        infix(TokenType::ASSIGN, &Parser::assignment, Precedence::ASSIGNMENT);
+        infix(TokenType::PLUS_ASSIGN, &Parser::assignment, Precedence::ASSIGNMENT, BinaryExpression::Operator::ADD);
+        infix(TokenType::MINUS_ASSIGN, &Parser::assignment, Precedence::ASSIGNMENT,
+              BinaryExpression::Operator::SUBTRACT);
+        infix(TokenType::MULTIPLY_ASSIGN, &Parser::assignment, Precedence::ASSIGNMENT,
+              BinaryExpression::Operator::MULTIPLY);
+        infix(TokenType::DIVIDE_ASSIGN, &Parser::assignment, Precedence::ASSIGNMENT,
+              BinaryExpression::Operator::DIVIDE);
+        infix(TokenType::MODULO_ASSIGN, &Parser::assignment, Precedence::ASSIGNMENT,
+              BinaryExpression::Operator::MODULO);
+
+        infix(TokenType::LOGICAL_OR, &Parser::logical, Precedence::LOGICAL_OR);
+        infix(TokenType::LOGICAL_AND, &Parser::logical, Precedence::LOGICAL_AND);
+
+        infix(TokenType::BITWISE_OR, &Parser::binary, Precedence::BITWISE_OR, BinaryExpression::Operator::BITWISE_OR);
+        infix(TokenType::BITWISE_XOR, &Parser::binary, Precedence::BITWISE_XOR,
+              BinaryExpression::Operator::BITWISE_XOR);
+        infix(TokenType::BITWISE_AND, &Parser::binary, Precedence::BITWISE_AND,
+              BinaryExpression::Operator::BITWISE_AND);
+
+        infix(TokenType::EQUAL, &Parser::binary, Precedence::EQUALITY, BinaryExpression::Operator::EQUAL);
+        infix(TokenType::NOT_EQUAL, &Parser::binary, Precedence::EQUALITY, BinaryExpression::Operator::NOT_EQUAL);
+        infix(TokenType::STRICT_EQUAL, &Parser::binary, Precedence::EQUALITY,
+              BinaryExpression::Operator::STRICT_EQUAL);
+        infix(TokenType::STRICT_NOT_EQUAL, &Parser::binary, Precedence::EQUALITY,
+              BinaryExpression::Operator::STRICT_NOT_EQUAL);
+
+        infix(TokenType::LESS_THAN, &Parser::binary, Precedence::COMPARISON, BinaryExpression::Operator::LESS);
+        infix(TokenType::LESS_EQUAL, &Parser::binary, Precedence::COMPARISON, BinaryExpression::Operator::LESS_EQUAL);
+        infix(TokenType::GREATER_THAN, &Parser::binary, Precedence::COMPARISON, BinaryExpression::Operator::GREATER);
+        infix(TokenType::GREATER_EQUAL, &Parser::binary, Precedence::COMPARISON,
+              BinaryExpression::Operator::GREATER_EQUAL);
+
+        infix(TokenType::LEFT_SHIFT, &Parser::binary, Precedence::SHIFT, BinaryExpression::Operator::LEFT_SHIFT);
+        infix(TokenType::RIGHT_SHIFT, &Parser::binary, Precedence::SHIFT, BinaryExpression::Operator::RIGHT_SHIFT);
+        infix(TokenType::UNSIGNED_RIGHT_SHIFT, &Parser::binary, Precedence::SHIFT,
+              BinaryExpression::Operator::UNSIGNED_RIGHT_SHIFT);
+
+        infix(TokenType::PLUS, &Parser::binary, Precedence::TERM, BinaryExpression::Operator::ADD);
+        infix(TokenType::MINUS, &Parser::binary, Precedence::TERM, BinaryExpression::Operator::SUBTRACT);
+
+        infix(TokenType::MULTIPLY, &Parser::binary, Precedence::FACTOR, BinaryExpression::Operator::MULTIPLY);
+        infix(TokenType::DIVIDE, &Parser::binary, Precedence::FACTOR, BinaryExpression::Operator::DIVIDE);
+        infix(TokenType::MODULO, &Parser::binary, Precedence::FACTOR, BinaryExpression::Operator::MODULO);
+
+        infix(TokenType::LEFT_PAREN, &Parser::finishCall, Precedence::CALL);
+        infix(TokenType::DOT, &Parser::property, Precedence::CALL);
+        return table;
+    }();
+    return rules[static_cast<size_t>(type)];
 }
 
-
-unique_ptr<Expression> Parser::logicalOr() {
-    auto expr = logicalAnd();
-
-    while (match({TokenType::LOGICAL_OR})) {
-        Token op = previous();
-        auto right = logicalAnd();
-        expr = make_unique<LogicalExpression>(move(expr), LogicalExpression::Operator::Or, move(right));
-    }
-
-    return expr;
+unique_ptr<Expression> Parser::expression() {
+    return parsePrecedence(Precedence::ASSIGNMENT);
 }
 
-unique_ptr<Expression> Parser::logicalAnd() {
-    auto expr = equality();
-
-    while (match({TokenType::LOGICAL_AND})) {
-        Token op = previous();
-        auto right = equality();
-        expr = make_unique<LogicalExpression>(move(expr), LogicalExpression::Operator::And, move(right));
+// Parses an expression whose infix operators all bind at least as tightly as `precedence`
+unique_ptr<Expression> Parser::parsePrecedence(const Precedence precedence) {
+    const PrefixRule prefix = getRule(peek().type).prefix;
+    if (prefix == nullptr) {
+        // Stand in a null literal so the enclosing declaration can finish parsing
+        error(peek(), "Expected expression.");
+        return make_unique<LiteralExpression>(TokenType::NULL_LITERAL, Value());
     }
+    advance();
+    unique_ptr<Expression> expr = (this->*prefix)();
 
-    return expr;
-}
-
-unique_ptr<Expression> Parser::equality() {
-    auto expr = comparison();
-
-    while (match({TokenType::EQUAL, TokenType::NOT_EQUAL, TokenType::STRICT_EQUAL, TokenType::STRICT_NOT_EQUAL})) {
-        Token op = previous();
-        auto right = comparison();
-        BinaryExpression::Operator binaryOp;
-        switch (op.type) {
-            case TokenType::EQUAL:
-                binaryOp = BinaryExpression::Operator::EQUAL;
-                break;
-            case TokenType::NOT_EQUAL:
-                binaryOp = BinaryExpression::Operator::NOT_EQUAL;
-                break;
-            case TokenType::STRICT_EQUAL:
-                binaryOp = BinaryExpression::Operator::STRICT_EQUAL;
-                break;
-            case TokenType::STRICT_NOT_EQUAL:
-                binaryOp = BinaryExpression::Operator::STRICT_NOT_EQUAL;
-                break;
-            default:
-                binaryOp = BinaryExpression::Operator::UNKNOWN;
-                break;
+    while (true) {
+        const ParseRule &rule = getRule(peek().type);
+        if (rule.infix == nullptr || rule.precedence < precedence) {
+            break;
         }
-        expr = make_unique<BinaryExpression>(move(expr), binaryOp, move(right));
+        advance();
+        expr = (this->*rule.infix)(move(expr));
     }
 
     return expr;
 }
 
-unique_ptr<Expression> Parser::comparison() {
-    auto expr = term();
+// Prefix rules, called with the token that starts the expression already consumed
 
-    while (match({TokenType::LESS_THAN, TokenType::LESS_EQUAL, TokenType::GREATER_THAN, TokenType::GREATER_EQUAL})) {
-        Token op = previous();
-        auto right = term();
-        BinaryExpression::Operator binaryOp;
-        switch (op.type) {
-            case TokenType::LESS_THAN:
-                binaryOp = BinaryExpression::Operator::LESS;
-                break;
-            case TokenType::LESS_EQUAL:
-                binaryOp = BinaryExpression::Operator::LESS_EQUAL;
-                break;
-            case TokenType::GREATER_THAN:
-                binaryOp = BinaryExpression::Operator::GREATER;
-                break;
-            case TokenType::GREATER_EQUAL:
-                binaryOp = BinaryExpression::Operator::GREATER_EQUAL;
-                break;
-            default:
-                binaryOp = BinaryExpression::Operator::UNKNOWN;
-                break;
-        }
-        expr = make_unique<BinaryExpression>(move(expr), binaryOp, move(right));
+unique_ptr<Expression> Parser::literal() {
+    const Token &token = previous();
+    switch (token.type) {
+        case TokenType::BOOLEAN_LITERAL:
+            return make_unique<LiteralExpression>(TokenType::BOOLEAN_LITERAL,
+                                                  Value(tokens_.text(token) == "true" ? true : false));
+        case TokenType::DOUBLE_LITERAL:
+            return make_unique<LiteralExpression>(TokenType::DOUBLE_LITERAL, Value(token.number));
+        case TokenType::STRING_LITERAL:
+            return make_unique<LiteralExpression>(TokenType::STRING_LITERAL, Value(token.symbol.str()));
+        default:
+            return make_unique<LiteralExpression>(TokenType::NULL_LITERAL, Value());
     }
-
-    return expr;
 }
 
-unique_ptr<Expression> Parser::term() {
-    auto expr = factor();
-
-    while (match({TokenType::PLUS, TokenType::MINUS})) {
-        Token op = previous();
-        auto right = factor();
-        BinaryExpression::Operator binaryOp = (op.type == TokenType::PLUS)
-                                                  ? BinaryExpression::Operator::ADD
-                                                  : BinaryExpression::Operator::SUBTRACT;
-        expr = make_unique<BinaryExpression>(move(expr), binaryOp, move(right));
-    }
-
-    return expr;
+unique_ptr<Expression> Parser::identifier() {
+    return make_unique<IdentifierExpression>(previous().symbol);
 }
 
-unique_ptr<Expression> Parser::factor() {
-    auto expr = unary();
-
-    while (match({TokenType::MULTIPLY, TokenType::DIVIDE, TokenType::MODULO})) {
-        Token op = previous();
-        auto right = unary();
-        BinaryExpression::Operator binaryOp;
-        switch (op.type) {
-            case TokenType::MULTIPLY:
-                binaryOp = BinaryExpression::Operator::MULTIPLY;
-                break;
-            case TokenType::DIVIDE:
-                binaryOp = BinaryExpression::Operator::DIVIDE;
-                break;
-            case TokenType::MODULO:
-                binaryOp = BinaryExpression::Operator::MODULO;
-                break;
-            default:
-                binaryOp = BinaryExpression::Operator::UNKNOWN;
-                break;
-        }
-        expr = make_unique<BinaryExpression>(move(expr), binaryOp, move(right));
-    }
-
+unique_ptr<Expression> Parser::grouping() {
+    auto expr = expression();
+    consume(TokenType::RIGHT_PAREN, "Expected ')' after expression.");
     return expr;
 }
 
 unique_ptr<Expression> Parser::unary() {
-    if (match({TokenType::LOGICAL_NOT, TokenType::MINUS})) {
-        Token op = previous();
-        auto right = unary();
-        UnaryExpression::Operator unaryOp = (op.type == TokenType::LOGICAL_NOT)
-                                                ? UnaryExpression::Operator::Not
-                                                : UnaryExpression::Operator::Negate;
-        return make_unique<UnaryExpression>(unaryOp, move(right));
+    UnaryExpression::Operator unaryOp;
+    switch (previous().type) {
+        case TokenType::LOGICAL_NOT:
+            unaryOp = UnaryExpression::Operator::Not;
+            break;
+        case TokenType::BITWISE_NOT:
+            unaryOp = UnaryExpression::Operator::BitwiseNot;
+            break;
+        default:
+            unaryOp = UnaryExpression::Operator::Negate;
+            break;
     }
+    auto right = parsePrecedence(Precedence::UNARY);
+    return make_unique<UnaryExpression>(unaryOp, move(right));
+}
+
+// Infix rules, called with the left operand and with the operator already consumed
+
+unique_ptr<Expression> Parser::binary(unique_ptr<Expression> left) {
+    const ParseRule &rule = getRule(previous().type);
+    // Binary operators are left-associative, so the right operand only takes tighter operators
+    auto right = parsePrecedence(static_cast<Precedence>(static_cast<uint8_t>(rule.precedence) + 1));
+    return make_unique<BinaryExpression>(move(left), rule.op, move(right));
+}
 
-    return call();
+unique_ptr<Expression> Parser::logical(unique_ptr<Expression> left) {
+    const TokenType type = previous().type;
+    const LogicalExpression::Operator logicalOp = type == TokenType::LOGICAL_AND
+                                                      ? LogicalExpression::Operator::And
+                                                      : LogicalExpression::Operator::Or;
+    auto right = parsePrecedence(static_cast<Precedence>(static_cast<uint8_t>(getRule(type).precedence) + 1));
+    return make_unique<LogicalExpression>(move(left), logicalOp, move(right));
 }
 
-unique_ptr<Expression> Parser::call() {
-    unique_ptr<Expression> expr = primary();
+unique_ptr<Expression> Parser::assignment(unique_ptr<Expression> target) {
+    Token op = previous(); // The assignment operator token
+    const BinaryExpression::Operator binaryOp = getRule(op.type).op;
+    auto value = parsePrecedence(Precedence::ASSIGNMENT); // Right-associative: `a = b = c`
 
-    while (true) {
-        if (match({TokenType::LEFT_PAREN})) {
-            expr = finishCall(move(expr));
-        } else if (match({TokenType::DOT})) {
-            Token name = consume(TokenType::IDENTIFIER, "Expected property name after '.'.");
-            expr = make_unique<GetExpression>(move(expr), name.value);
-        } else {
-            break;
-        }
+    // Check if the left-hand side is a valid assignment target
+    auto varExpr = dynamic_cast<IdentifierExpression *>(target.get());
+    if (varExpr == nullptr) {
+        error(op, "Invalid assignment target.");
+        return target;
     }
+    Symbol name = varExpr->getName();
 
-    return expr;
+    // If it's a compound assignment, assign the result of the binary operation: `a = a + b`
+    if (op.type != TokenType::ASSIGN) {
+        auto binaryExpr = make_unique<BinaryExpression>(make_unique<IdentifierExpression>(name), binaryOp,
+                                                        move(value));
+        return make_unique<AssignmentExpression>(name, move(binaryExpr), TokenType::ASSIGN);
+    }
+
+    return make_unique<AssignmentExpression>(name, move(value), op.type);
 }
 
 unique_ptr<Expression> Parser::finishCall(unique_ptr<Expression> callee) {
@@ -475,39 +472,20 @@ unique_ptr<Expression> Parser::finishCall(unique_ptr<Expression> callee) {
     return make_unique<FunctionCallExpression>(move(callee), move(arguments));
 }
 
-unique_ptr<Expression> Parser::primary() {
-    if (match({TokenType::BOOLEAN_LITERAL})) {
-        return make_unique<LiteralExpression>(TokenType::BOOLEAN_LITERAL,
-                                              make_shared<BoolValue>(previous().value == "true" ? true : false));
-    }
-    if (match({TokenType::NULL_LITERAL})) {
-        return make_unique<LiteralExpression>(TokenType::NULL_LITERAL, nullptr);
-    }
-
-    if (match({TokenType::DOUBLE_LITERAL})) {
-        return make_unique<LiteralExpression>(TokenType::DOUBLE_LITERAL,
-                                              make_shared<DoubleValue>(stod(previous().value)));
-    }
-    if (match({TokenType::STRING_LITERAL})) {
-        return make_unique<LiteralExpression>(TokenType::STRING_LITERAL, make_shared<StringValue>(previous().value));
-    }
-    if (match({TokenType::IDENTIFIER})) {
-        return make_unique<IdentifierExpression>(previous().value);
-    }
-    if (match({TokenType::LEFT_PAREN})) {
-        auto expr = expression();
-        consume(TokenType::RIGHT_PAREN, "Expected ')' after expression.");
-        return expr;
-    }
-
-    error(peek(), "Expected expression.");
-    throw runtime_error("Parsing Error");
+unique_ptr<Expression> Parser::property(unique_ptr<Expression> object) {
+    Token name = consume(TokenType::IDENTIFIER, "Expected property name after '.'.");
+    return make_unique<GetExpression>(move(object), name.symbol);
 }
 
 // Error Handling
 
-void Parser::synchronize() {
-    advance();
+void Parser::synchronize(const uint32_t declarationStart) {
+    panicking_ = false;
+
+    // Always make progress, even when the error was on the declaration's first token
+    if (peek().offset == declarationStart) {
+        advance();
+    }
 
     while (!isAtEnd()) {
         if (previous().type == TokenType::SEMICOLON) return;
@@ -531,9 +509,22 @@ void Parser::synchronize() {
     }
 }
 
+// Records an error at `token`, unless the current declaration already has one: errors after the
+// first are usually knock-on effects of it. Bad input the Lexer reported, and the end of a file that
+// stops right after it, only get the Lexer's error.
 void Parser::error(const Token &token, const string &message) {
-    cerr << "[Line " << token.line << ", Column " << token.column << "] Error at '" << token.value << "': " << message
-            << endl;
+    if (panicking_) {
+        return;
+    }
+    panicking_ = true;
+    if (token.type == TokenType::UNKNOWN ||
+        (token.type == TokenType::EOF_TOKEN && tokens_.afterLexerError())) {
+        return;
+    }
+
+    const SourceLocation location = tokens_.locate(token);
+    const uint32_t length = token.type == TokenType::EOF_TOKEN ? 0 : token.length;
+    diagnostics_.push_back({Diagnostic::Severity::ERROR, location.line, location.column, message, token.offset, length});
 }
 
 
@@ -2,7 +2,11 @@
 #define PARSER_H
 
 #include "../../include/Token.h"
+#include "../lexer/TokenStream.h"
 #include "../ast/AST.h"
+#include "../ast/CompilationUnit.h"
+#include <array>
+#include <initializer_list>
 #include <vector>
 #include <memory>
 #include <stdexcept>
@@ -10,14 +14,25 @@
 
 class Parser {
 public:
-    Parser(const vector<Token> &tokens);
+    // Pulls tokens from `tokens` as it goes; the stream must outlive the parser
+    Parser(TokenStream &tokens);
 
     // Parses the entire input and returns a list of statements
     vector<unique_ptr<Statement> > parse();
 
+    // Parses the entire input into `unit`, allocating every node from the unit's arena and
+    // collecting the lexer's and parser's diagnostics alongside
+    void parseInto(CompilationUnit &unit);
+
+    // Errors found so far. Statements containing an error are left out of the parse result.
+    const vector<Diagnostic> &getDiagnostics() const;
+
 private:
-    const vector<Token> &tokens_;
-    size_t current_;
+    TokenStream &tokens_;
+    vector<Diagnostic> diagnostics_;
+
+    // Set by the first error in a declaration; later errors are suppressed until synchronize()
+    bool panicking_ = false;
 
     // Helper methods
     bool isAtEnd() const;
@@ -30,7 +45,7 @@ private:
 
     bool check(TokenType type) const;
 
-    bool match(const vector<TokenType> &types);
+    bool match(initializer_list<TokenType> types);
 
     Token consume(TokenType type, const string &errorMessage);
 
@@ -55,32 +70,62 @@ private:
 
     unique_ptr<Statement> expressionStatement();
 
-    unique_ptr<Expression> expression();
+    // Expressions, parsed by precedence climbing over the table in getRule()
+
+    // Binding strength of infix operators, loosest first
+    enum class Precedence : uint8_t {
+        NONE,
+        ASSIGNMENT, // = += -= *= /= %=
+        LOGICAL_OR, // ||
+        LOGICAL_AND, // &&
+        BITWISE_OR, // |
+        BITWISE_XOR, // ^
+        BITWISE_AND, // &
+        EQUALITY, // == != === !==
+        COMPARISON, // < > <= >=
+        SHIFT, // << >> >>>
+        TERM, // + -
+        FACTOR, // * / %
+        UNARY, // ! - ~
+        CALL, // () .
+    };
+
+    using PrefixRule = unique_ptr<Expression> (Parser::*)();
+    using InfixRule = unique_ptr<Expression> (Parser::*)(unique_ptr<Expression> left);
+
+    struct ParseRule {
+        PrefixRule prefix = nullptr; // Parses an expression starting with the token
+        InfixRule infix = nullptr; // Parses the rest of an expression the token continues
+        Precedence precedence = Precedence::NONE; // Of the token as an infix operator
+        BinaryExpression::Operator op = BinaryExpression::Operator::UNKNOWN; // Applied by binary and compound assignments
+    };
+
+    static const ParseRule &getRule(TokenType type);
 
-    unique_ptr<Expression> assignment();
+    unique_ptr<Expression> expression();
 
-    unique_ptr<Expression> logicalOr();
+    unique_ptr<Expression> parsePrecedence(Precedence precedence);
 
-    unique_ptr<Expression> logicalAnd();
+    unique_ptr<Expression> literal();
 
-    unique_ptr<Expression> equality();
+    unique_ptr<Expression> identifier();
 
-    unique_ptr<Expression> comparison();
+    unique_ptr<Expression> grouping();
 
-    unique_ptr<Expression> term();
+    unique_ptr<Expression> unary();
 
-    unique_ptr<Expression> factor();
+    unique_ptr<Expression> binary(unique_ptr<Expression> left);
 
-    unique_ptr<Expression> unary();
+    unique_ptr<Expression> logical(unique_ptr<Expression> left);
 
-    unique_ptr<Expression> call();
+    unique_ptr<Expression> assignment(unique_ptr<Expression> target);
 
     unique_ptr<Expression> finishCall(unique_ptr<Expression> callee);
 
-    unique_ptr<Expression> primary();
+    unique_ptr<Expression> property(unique_ptr<Expression> object);
 
     // Error handling
-    void synchronize();
+    void synchronize(uint32_t declarationStart);
 
     void error(const Token &token, const string &message);
 };
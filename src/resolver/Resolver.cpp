@@ -0,0 +1,137 @@
+#include "Resolver.h"
+
+#include <stdexcept>
+
+#include "ast/AST.h"
+
+using namespace std;
+
+
+void Resolver::resolve(const vector<unique_ptr<Statement> > &statements) {
+    scopes_.assign(1, {}); // The global scope
+    for (const auto &statement: statements) {
+        statement->accept(*this);
+    }
+}
+
+Value Resolver::visitLiteralExpression(LiteralExpression *expression) {
+    return {};
+}
+
+Value Resolver::visitIdentifierExpression(IdentifierExpression *expression) {
+    int depth, slot;
+    if (find(expression->getName(), depth, slot)) {
+        expression->resolve(depth, slot);
+    }
+    return {};
+}
+
+Value Resolver::visitBinaryExpression(BinaryExpression *expression) {
+    expression->getLeft()->accept(*this);
+    expression->getRight()->accept(*this);
+    return {};
+}
+
+Value Resolver::visitUnaryExpression(UnaryExpression *expression) {
+    expression->getRight()->accept(*this);
+    return {};
+}
+
+Value Resolver::visitAssignmentExpression(AssignmentExpression *expression) {
+    expression->getValue()->accept(*this);
+
+    int depth, slot;
+    if (find(expression->getName(), depth, slot)) {
+        if (scopes_[scopes_.size() - 1 - depth][slot].isConst) {
+            throw runtime_error("Cannot reassign constant variable '" + expression->getName().str() + "'.");
+        }
+        expression->resolve(depth, slot);
+    }
+    return {};
+}
+
+Value Resolver::visitLogicalExpression(LogicalExpression *expression) {
+    expression->getLeft()->accept(*this);
+    expression->getRight()->accept(*this);
+    return {};
+}
+
+Value Resolver::visitFunctionCallExpression(FunctionCallExpression *expression) {
+    expression->getCallee()->accept(*this);
+    for (const auto &argument: expression->getArguments()) {
+        argument->accept(*this);
+    }
+    return {};
+}
+
+Value Resolver::visitGetExpression(GetExpression *expression) {
+    expression->getObject()->accept(*this);
+    return {};
+}
+
+void Resolver::visitExpressionStatement(ExpressionStatement *statement) {
+    statement->getExpression()->accept(*this);
+}
+
+void Resolver::visitVariableDeclaration(VariableDeclaration *statement) {
+    // The initializer is resolved before the variable exists, so `let x = x;` reads the outer x
+    if (statement->hasInitializer()) {
+        statement->getInitializer()->accept(*this);
+    }
+
+    vector<Variable> &scope = scopes_.back();
+    for (const Variable &variable: scope) {
+        if (variable.name == statement->getName()) {
+            throw runtime_error("Variable '" + statement->getName().str() + "' is already defined.");
+        }
+    }
+    scope.push_back({statement->getName(), statement->getTypeName() == "const"});
+    statement->setSlot(static_cast<int>(scope.size() - 1));
+}
+
+void Resolver::visitBlockStatement(BlockStatement *statement) {
+    scopes_.emplace_back();
+    for (const auto &inner: statement->getStatements()) {
+        if (inner) {
+            inner->accept(*this);
+        }
+    }
+    scopes_.pop_back();
+}
+
+void Resolver::visitIfStatement(IfStatement *statement) {
+    statement->getCondition()->accept(*this);
+    statement->getThenBranch()->accept(*this);
+    if (statement->getElseBranch()) {
+        statement->getElseBranch()->accept(*this);
+    }
+}
+
+void Resolver::visitWhileStatement(WhileStatement *statement) {
+    statement->getCondition()->accept(*this);
+    statement->getBody()->accept(*this);
+}
+
+void Resolver::visitReturnStatement(ReturnStatement *statement) {
+    if (statement->getValue()) {
+        statement->getValue()->accept(*this);
+    }
+}
+
+// The Interpreter does not execute function declarations yet, so their bodies are left unresolved
+void Resolver::visitFunctionDeclaration(FunctionDeclaration *statement) {
+}
+
+bool Resolver::find(const Symbol name, int &depth, int &slot) const {
+    for (int scope = static_cast<int>(scopes_.size()) - 1; scope >= 0; scope--) {
+        const vector<Variable> &variables = scopes_[scope];
+        for (int index = static_cast<int>(variables.size()) - 1; index >= 0; index--) {
+            if (variables[index].name == name) {
+                depth = static_cast<int>(scopes_.size()) - 1 - scope;
+                slot = index;
+                return true;
+            }
+        }
+    }
+    return false;
+}
@@ -0,0 +1,64 @@
+#ifndef RESOLVER_H
+#define RESOLVER_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../visitor/Visitor.h"
+
+// Static pass run before the Interpreter. It mirrors the Interpreter's scopes (the global
+// environment plus one per block) and annotates every variable declaration, read and
+// assignment with the slot it lives in and how many scopes up that is. Redeclarations and
+// assignments to constants are reported here instead of at runtime.
+class Resolver : public Visitor {
+public:
+    // Resolves a whole program; throws runtime_error on the first invalid variable use
+    void resolve(const vector<unique_ptr<Statement> > &statements);
+
+    // Visitor methods for expressions
+    Value visitLiteralExpression(LiteralExpression *expression) override;
+
+    Value visitIdentifierExpression(IdentifierExpression *expression) override;
+
+    Value visitBinaryExpression(BinaryExpression *expression) override;
+
+    Value visitUnaryExpression(UnaryExpression *expression) override;
+
+    Value visitAssignmentExpression(AssignmentExpression *expression) override;
+
+    Value visitLogicalExpression(LogicalExpression *expression) override;
+
+    Value visitFunctionCallExpression(FunctionCallExpression *expression) override;
+
+    Value visitGetExpression(GetExpression *expression) override;
+
+    // Visitor methods for statements
+    void visitExpressionStatement(ExpressionStatement *statement) override;
+
+    void visitVariableDeclaration(VariableDeclaration *statement) override;
+
+    void visitBlockStatement(BlockStatement *statement) override;
+
+    void visitIfStatement(IfStatement *statement) override;
+
+    void visitWhileStatement(WhileStatement *statement) override;
+
+    void visitReturnStatement(ReturnStatement *statement) override;
+
+    void visitFunctionDeclaration(FunctionDeclaration *statement) override;
+
+private:
+    struct Variable {
+        Symbol name;
+        bool isConst;
+    };
+
+    // Innermost scope last; a variable's slot is its index within its scope
+    vector<vector<Variable> > scopes_;
+
+    // Finds a name from the innermost scope outwards; returns false for names left to runtime lookup
+    bool find(Symbol name, int &depth, int &slot) const;
+};
+
+#endif // RESOLVER_H
@@ -4,41 +4,215 @@
 #include "function/Function.h"
 
 #include <sstream>
+#include <vector>
 
+static_assert(sizeof(Value) == 16, "Value must stay a 16-byte tagged union");
 
-std::shared_ptr<Object> Value::asObject() const {
-    if (isClass()) {
-        return std::static_pointer_cast<Object>(asClass());
+StringValue::StringValue(string value)
+    : ValueType(TokenType::STRING_LITERAL), value_(move(value)), length_(value_.size()) {
+}
+
+StringValue::StringValue(const StringValue *left, const StringValue *right)
+    : ValueType(TokenType::STRING_LITERAL), left_(left), right_(right), length_(left->length_ + right->length_) {
+}
+
+StringValue::~StringValue() {
+    if (left_) {
+        releaseOperands();
     }
-    if (isFunction()) {
-        return std::static_pointer_cast<Object>(asFunction());
+}
+
+void StringValue::printValue() const {
+    cout << getBaseValue() << endl;
+}
+
+size_t StringValue::hash() const {
+    if (!hashed_) {
+        hash_ = std::hash<string_view>{}(getBaseValue());
+        hashed_ = true;
     }
-    auto objectValue = dynamic_cast<ObjectValue *>(value.get());
-    if (objectValue) return objectValue->getBaseValue();
-    throw std::runtime_error("Not an object value");
+    return hash_;
 }
 
-shared_ptr<Class> Value::asClass() const {
-    auto classValue = dynamic_cast<ClassValue *>(value.get());
-    if (classValue) return classValue->getBaseValue();
-    throw std::runtime_error("Not a class value");
+// Copies the leaves in order, walking the operands with a worklist: ropes built by appending in
+// a loop are as deep as the loop ran, too deep to recurse through
+void StringValue::flatten() const {
+    string flat;
+    flat.reserve(length_);
+    vector<const StringValue *> pending = {right_, left_};
+    while (!pending.empty()) {
+        const StringValue *node = pending.back();
+        pending.pop_back();
+        if (node->left_) {
+            pending.push_back(node->right_);
+            pending.push_back(node->left_);
+        } else {
+            flat += node->value_;
+        }
+    }
+    value_ = move(flat);
+    releaseOperands();
 }
 
-shared_ptr<Function> Value::asFunction() const {
-    auto functionValue = dynamic_cast<FunctionValue *>(value.get());
-    if (functionValue) return functionValue->getBaseValue();
-    throw std::runtime_error("Not a function value");
+// Letting go of the operands may free a whole chain of rope nodes; free them one after the
+// other rather than from each other's destructors
+void StringValue::releaseOperands() const {
+    vector<const StringValue *> pending = {left_, right_};
+    left_ = nullptr;
+    right_ = nullptr;
+    while (!pending.empty()) {
+        const StringValue *node = pending.back();
+        pending.pop_back();
+        if (node->release()) {
+            if (node->left_) {
+                pending.push_back(node->left_);
+                pending.push_back(node->right_);
+                node->left_ = nullptr;
+                node->right_ = nullptr;
+            }
+            delete node;
+        }
+    }
+}
+
+Value::Value(const double doubleValue) : Value(TokenType::DOUBLE_LITERAL) {
+    payload().number = doubleValue;
+}
+
+Value::Value(std::string stringValue) : Value(TokenType::STRING_LITERAL) {
+    if (stringValue.size() <= SMALL_STRING_CAPACITY) {
+        storage_ = Value(stringValue, {}).storage_;
+    } else {
+        payload().heap = new StringValue(move(stringValue));
+    }
+}
+
+Value::Value(const bool boolValue) : Value(TokenType::BOOLEAN_LITERAL) {
+    payload().boolean = boolValue;
+}
+
+Value::Value(Class *classValue) : Value(TokenType::CLASS) {
+    payload().object = classValue;
+}
+
+Value::Value(Function *functionValue) : Value(TokenType::FUNCTION) {
+    payload().object = functionValue;
+}
+
+Value::Value(Object *objectValue) : Value(TokenType::OBJECT) {
+    payload().object = objectValue;
 }
 
-bool Value::isClass() const {
-    return dynamic_cast<ClassValue *>(value.get()) != nullptr;
+// Takes ownership of a freshly allocated box; the Value's tag is taken from the box so the two never disagree
+Value::Value(ValueType *heapValue) : Value(heapValue->getType()) {
+    payload().heap = heapValue;
 }
 
-bool Value::isFunction() const {
-    return dynamic_cast<FunctionValue *>(value.get()) != nullptr;
+Value::Value(const string_view first, const string_view second) {
+    storage_.small = {TokenType::STRING_LITERAL, static_cast<uint8_t>(first.size() + second.size() + 1), {}};
+    first.copy(storage_.small.characters, first.size());
+    second.copy(storage_.small.characters + first.size(), second.size());
 }
 
-bool Value::isObject() const {
-    return dynamic_cast<ObjectValue *>(value.get()) != nullptr;
+// Short results are built directly, and long ones only copy their operands when those are short
+// too; past that, concatenating is one new rope node that shares both operands
+Value Value::concatenate(const Value &left, const Value &right) {
+    const size_t length = left.stringLength() + right.stringLength();
+    if (length <= SMALL_STRING_CAPACITY) {
+        return {left.asString(), right.asString()};
+    }
+    if (length < MIN_ROPE_LENGTH) {
+        string joined;
+        joined.reserve(length);
+        joined += left.asString();
+        joined += right.asString();
+        return Value(new StringValue(move(joined)));
+    }
+    return Value(new StringValue(left.shareBox(), right.shareBox()));
+}
+
+const StringValue *Value::shareBox() const {
+    if (isSmall()) {
+        return new StringValue(string(asString()));
+    }
+    box()->retain();
+    return box();
+}
+
+// Most unequal strings differ in length, or in hash where both boxes have computed theirs;
+// only the rest are compared character by character, which flattens rope nodes
+bool Value::equalsString(const Value &other) const {
+    if (stringLength() != other.stringLength()) {
+        return false;
+    }
+    if (isBoxed() && other.isBoxed()) {
+        if (box() == other.box()) {
+            return true;
+        }
+        if (box()->hasHash() && other.box()->hasHash() && box()->hash() != other.box()->hash()) {
+            return false;
+        }
+    }
+    return asString() == other.asString();
+}
+
+size_t Value::hash() const {
+    switch (getType()) {
+        case TokenType::DOUBLE_LITERAL:
+            return std::hash<double>{}(payload().number);
+        case TokenType::BOOLEAN_LITERAL:
+            return std::hash<bool>{}(payload().boolean);
+        case TokenType::STRING_LITERAL:
+            return isBoxed() ? box()->hash() : std::hash<string_view>{}(asString());
+        case TokenType::NULL_LITERAL:
+            return 0;
+        default:
+            return std::hash<const Object *>{}(payload().object);
+    }
 }
 
+Object *Value::asObject() const {
+    if (isObject() || isClass() || isFunction()) {
+        return payload().object;
+    }
+    throw std::runtime_error("Not an object value");
+}
+
+Class *Value::asClass() const {
+    if (isClass()) return static_cast<Class *>(payload().object);
+    throw std::runtime_error("Not a class value");
+}
+
+Function *Value::asFunction() const {
+    if (isFunction()) return static_cast<Function *>(payload().object);
+    throw std::runtime_error("Not a function value");
+}
+
+void Value::printValue() const {
+    switch (getType()) {
+        case TokenType::DOUBLE_LITERAL:
+            cout << payload().number << endl;
+            break;
+        case TokenType::BOOLEAN_LITERAL:
+            cout << (payload().boolean ? "true" : "false") << endl;
+            break;
+        case TokenType::NULL_LITERAL:
+            cout << "null" << endl;
+            break;
+        case TokenType::CLASS:
+            cout << "<Class " << asClass() << ">" << endl;
+            break;
+        case TokenType::FUNCTION:
+            cout << "<Function>" << endl;
+            break;
+        case TokenType::OBJECT:
+            cout << "<Object>" << endl;
+            break;
+        case TokenType::STRING_LITERAL:
+            cout << asString() << endl;
+            break;
+        default:
+            payload().heap->printValue();
+            break;
+    }
+}
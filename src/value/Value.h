@@ -1,11 +1,14 @@
 #ifndef VALUE_H
 #define VALUE_H
 
+#include <cmath>
+#include <cstdint>
+#include <functional>
 #include <iostream>
 #include <string>
+#include <string_view>
 #include <memory>
 #include "../../include/Token.h"
-#include "../ast/AST.h"
 
 class Class; // Forward declaration
 class Function; // Forward declaration
@@ -14,273 +17,346 @@ class Object; // Forward declaration
 using namespace std;
 
 
-// Base class ValueType with clone and printValue methods
+// Base class for boxed payloads, which only long strings use. Doubles, bools, null and short
+// strings are stored inline in Value, and objects, functions and classes are referenced from it
+// directly.
+// Each box carries the TokenType of the Value that owns it, so type tests never need RTTI.
+//
+// Boxes are immutable and shared: copying a Value adds a reference to its box instead of copying
+// the payload, and the last Value to let go deletes it. The count is not atomic, so a box and
+// the Values sharing it may only be handed from one thread to another, never used by two at once.
 class ValueType {
 public:
-    virtual ~ValueType() = default;
-
-    virtual void printValue() const = 0;
-
-    [[nodiscard]] virtual ValueType *clone() const = 0;
-};
-
-class StringValue final : public ValueType {
-    string value_;
-
-public:
-    explicit StringValue(string value) : value_(move(value)) {
+    explicit ValueType(const TokenType type) : type_(type) {
     }
 
-    void printValue() const override {
-        cout << value_ << endl;
-    }
+    ValueType(const ValueType &) = delete;
 
-    [[nodiscard]] ValueType *clone() const override {
-        return new StringValue(*this);
-    }
+    ValueType &operator=(const ValueType &) = delete;
 
-    [[nodiscard]] const string &getBaseValue() const {
-        return value_;
-    }
-};
-
-class BoolValue final : public ValueType {
-    bool value_;
-
-public:
-    explicit BoolValue(const bool value) : value_(value) {
-    }
-
-    void printValue() const override {
-        cout << (value_ ? "true" : "false") << endl;
-    }
-
-    [[nodiscard]] ValueType *clone() const override {
-        return new BoolValue(*this);
-    }
+    virtual ~ValueType() = default;
 
-    [[nodiscard]] bool getBaseValue() const {
-        return value_;
+    [[nodiscard]] TokenType getType() const {
+        return type_;
     }
-};
-
-class DoubleValue final : public ValueType {
-    double value_;
 
-public:
-    explicit DoubleValue(double value) : value_(value) {
-    }
+    virtual void printValue() const = 0;
 
-    void printValue() const override {
-        cout << value_ << endl;
+    void retain() const {
+        references_++;
     }
 
-    [[nodiscard]] ValueType *clone() const override {
-        return new DoubleValue(*this);
+    // Returns whether that was the last reference
+    [[nodiscard]] bool release() const {
+        return --references_ == 0;
     }
 
-    [[nodiscard]] double getBaseValue() const {
-        return value_;
-    }
+private:
+    TokenType type_;
+    mutable uint32_t references_ = 1;
 };
 
-class NullValue final : public ValueType {
+// The box of a string too long to be stored inline in its Value. It holds either the characters
+// or, as the result of a concatenation, the two strings it joins: a rope node. A rope node is
+// flattened the first time its characters are read and then lets go of its operands, so building
+// a string piece by piece costs in proportion to its final length rather than to its square.
+class StringValue final : public ValueType {
 public:
-    void printValue() const override {
-        cout << "null" << endl;
-    }
+    explicit StringValue(string value);
 
-    [[nodiscard]] ValueType *clone() const override {
-        return new NullValue(*this);
-    }
-
-    [[nodiscard]] static nullptr_t getBaseValue() {
-        return nullptr;
-    }
-};
+    // A rope node; takes over one reference to each operand
+    StringValue(const StringValue *left, const StringValue *right);
 
-class ClassValue final : public ValueType {
-    shared_ptr<Class> value_;
-
-public:
-    explicit ClassValue(shared_ptr<Class> value) : value_(move(value)) {
-    }
+    ~StringValue() override;
 
-    void printValue() const override {
-        cout << "<Class " << value_ << ">" << endl;
-    }
+    void printValue() const override;
 
-    [[nodiscard]] ValueType *clone() const override {
-        return new ClassValue(*this);
+    [[nodiscard]] size_t length() const {
+        return length_;
     }
 
-    [[nodiscard]] shared_ptr<Class> getBaseValue() const {
+    // The characters, flattening a rope node first
+    [[nodiscard]] const string &getBaseValue() const {
+        if (left_) {
+            flatten();
+        }
         return value_;
     }
-};
 
-class FunctionValue final : public ValueType {
-    shared_ptr<Function> value_;
+    // Computed on first use and kept, for strings used as map keys
+    [[nodiscard]] size_t hash() const;
 
-public:
-    explicit FunctionValue(shared_ptr<Function> value) : value_(move(value)) {
+    [[nodiscard]] bool hasHash() const {
+        return hashed_;
     }
 
-    void printValue() const override {
-        cout << "<Function>" << endl;
-    }
+private:
+    mutable string value_;
+    mutable const StringValue *left_ = nullptr; // Both operands are set while this is a rope node
+    mutable const StringValue *right_ = nullptr;
+    size_t length_;
+    mutable size_t hash_ = 0;
+    mutable bool hashed_ = false;
 
-    [[nodiscard]] ValueType *clone() const override {
-        return new FunctionValue(*this);
-    }
+    void flatten() const;
 
-    [[nodiscard]] shared_ptr<Function> getBaseValue() const {
-        return value_;
-    }
+    void releaseOperands() const;
 };
 
-class ObjectValue final : public ValueType {
-    shared_ptr<Object> value_;
-
+// Value is a 16-byte tagged union: the tag is the TokenType of the value, and the payload
+// is an inline double/bool, a reference to a shared, immutable string box whose own tag always
+// matches, or a plain pointer to an object, function or class that the garbage collector owns
+// (see gc/Heap.h). Strings of up to SMALL_STRING_CAPACITY characters skip the box and are stored
+// in the 14 bytes after the tag instead. Copying a Value never copies a boxed payload: it copies
+// the 16 bytes, and for a boxed string bumps the box's reference count. Every type test is a
+// single compare on the tag.
+class Value {
 public:
-    explicit ObjectValue(shared_ptr<Object> value) : value_(move(value)) {
-    }
+    static constexpr size_t SMALL_STRING_CAPACITY = 14;
 
-    void printValue() const override {
-        cout << "<Object>" << endl;
-    }
+    // Concatenations at least this long make a rope node instead of copying both operands
+    static constexpr size_t MIN_ROPE_LENGTH = 128;
 
-    [[nodiscard]] ValueType *clone() const override {
-        return new ObjectValue(*this);
+    Value() : Value(TokenType::NULL_LITERAL) {
     }
 
-    [[nodiscard]] shared_ptr<Object> getBaseValue() const {
-        return value_;
-    }
-};
-
-// Value class that holds a shared pointer to a ValueType
-class Value {
-public:
-    Value() = default;
-
     explicit Value(double doubleValue);
 
-    explicit Value(const std::string &stringValue);
+    explicit Value(std::string stringValue);
 
     explicit Value(bool boolValue);
 
-    explicit Value(std::shared_ptr<Class> classValue);
+    explicit Value(Class *classValue);
 
-    explicit Value(std::shared_ptr<Function> functionValue);
+    explicit Value(Function *functionValue);
 
-    explicit Value(std::shared_ptr<Object> objectValue);
+    explicit Value(Object *objectValue);
 
+    ~Value() {
+        if (isBoxed() && payload().heap->release()) {
+            delete payload().heap;
+        }
+    }
 
-    // Copy constructor for deep copy
+    // Copy constructor: inline payloads and object references are copied bitwise, boxes are shared
     Value(const Value &other)
-        : type(other.type), value(other.value ? shared_ptr<ValueType>(other.value->clone()) : nullptr) {
+        : storage_(other.storage_) {
+        if (isBoxed()) {
+            payload().heap->retain();
+        }
     }
 
-    // Assignment operator for deep copy
+    // Copy assignment shares the box the same way
     Value &operator=(const Value &other) {
         if (this != &other) {
-            type = other.type;
-            value = other.value ? shared_ptr<ValueType>(other.value->clone()) : nullptr;
+            Value copy(other);
+            swap(copy);
         }
         return *this;
     }
 
     // Move constructor
     Value(Value &&other) noexcept
-        : type(move(other.type)), value(move(other.value)) {
-        other.value = nullptr;
+        : storage_(other.storage_) {
+        other.storage_.regular = {TokenType::NULL_LITERAL, 0, {}};
     }
 
     // Move assignment operator
     Value &operator=(Value &&other) noexcept {
         if (this != &other) {
-            type = move(other.type);
-            value = move(other.value);
-            other.value = nullptr;
+            Value moved(std::move(other));
+            swap(moved);
         }
         return *this;
     }
 
     // Equality operator
     bool operator==(const Value &other) const {
-        if (this->type != other.type) {
+        if (this->getType() != other.getType()) {
             return false;
         }
-        switch (type) {
+        switch (getType()) {
             case TokenType::DOUBLE_LITERAL:
                 return this->asDouble() == other.asDouble();
             case TokenType::STRING_LITERAL:
-                return this->asString() == other.asString();
+                return this->equalsString(other);
             case TokenType::BOOLEAN_LITERAL:
                 return this->asBool() == other.asBool();
             case TokenType::NULL_LITERAL:
                 return this->isNull() == other.isNull();
+            // Objects, functions and classes are only equal to themselves
+            case TokenType::OBJECT:
+                return this->asObject() == other.asObject();
+            case TokenType::FUNCTION:
+                return this->asFunction() == other.asFunction();
+            case TokenType::CLASS:
+                return this->asClass() == other.asClass();
             default:
                 return false;
         }
     }
 
     // Type checking methods
-    [[nodiscard]] bool isNull() const { return type == TokenType::NULL_LITERAL; }
-    [[nodiscard]] bool isBool() const { return dynamic_cast<BoolValue *>(value.get()) != nullptr; }
-    [[nodiscard]] bool isDouble() const { return dynamic_cast<DoubleValue *>(value.get()) != nullptr; }
-    [[nodiscard]] bool isString() const { return dynamic_cast<StringValue *>(value.get()) != nullptr; }
-
-    [[nodiscard]] bool isClass() const;
-
-    [[nodiscard]] bool isFunction() const;
-
-    [[nodiscard]] bool isObject() const;
+    [[nodiscard]] bool isNull() const { return getType() == TokenType::NULL_LITERAL; }
+    [[nodiscard]] bool isBool() const { return getType() == TokenType::BOOLEAN_LITERAL; }
+    [[nodiscard]] bool isDouble() const { return getType() == TokenType::DOUBLE_LITERAL; }
+    [[nodiscard]] bool isString() const { return getType() == TokenType::STRING_LITERAL; }
+    [[nodiscard]] bool isClass() const { return getType() == TokenType::CLASS; }
+    [[nodiscard]] bool isFunction() const { return getType() == TokenType::FUNCTION; }
+    [[nodiscard]] bool isObject() const { return getType() == TokenType::OBJECT; }
 
 
     // Getters for various value types
     [[nodiscard]] bool asBool() const {
-        auto boolValue = dynamic_cast<BoolValue *>(value.get());
-        if (boolValue) {
-            return boolValue->getBaseValue();
+        if (isBool()) {
+            return payload().boolean;
         }
         throw runtime_error("Not a boolean value");
     }
 
     [[nodiscard]] double asDouble() const {
-        auto doubleValue = dynamic_cast<DoubleValue *>(value.get());
-        if (doubleValue) {
-            return doubleValue->getBaseValue();
+        if (isDouble()) {
+            return payload().number;
         }
         throw runtime_error("Not a double value");
     }
 
-    [[nodiscard]] string asString() const {
-        auto stringValue = dynamic_cast<StringValue *>(value.get());
-        if (stringValue) {
-            return stringValue->getBaseValue();
+    // The number as a 32-bit integer for the bitwise operators: truncated and wrapped modulo 2^32,
+    // with NaN and the infinities becoming 0, as in JavaScript
+    [[nodiscard]] int32_t asInt32() const {
+        const double number = asDouble();
+        if (!isfinite(number)) {
+            return 0;
+        }
+        double wrapped = fmod(trunc(number), 4294967296.0);
+        if (wrapped < 0) {
+            wrapped += 4294967296.0;
+        }
+        return static_cast<int32_t>(static_cast<uint32_t>(wrapped));
+    }
+
+    // The characters of a string, which stay valid as long as the Value does
+    [[nodiscard]] string_view asString() const {
+        if (!isString()) {
+            throw runtime_error("Not a string value");
+        }
+        if (isSmall()) {
+            return {storage_.small.characters, storage_.small.form - 1u};
+        }
+        return box()->getBaseValue();
+    }
+
+    // Joins two strings, making a rope node if the result is long
+    [[nodiscard]] static Value concatenate(const Value &left, const Value &right);
+
+    // Consistent with ==; a boxed string computes its hash once
+    [[nodiscard]] size_t hash() const;
+
+    // Truthiness shared by every execution engine
+    [[nodiscard]] bool isTruthy() const {
+        switch (getType()) {
+            case TokenType::BOOLEAN_LITERAL:
+                return payload().boolean; // If it's a boolean, return its actual value (true or false)
+            case TokenType::DOUBLE_LITERAL:
+                return payload().number != 0; // Numbers are truthy if they're not zero
+            case TokenType::STRING_LITERAL:
+                return stringLength() != 0; // Non-empty strings are truthy
+            default:
+                return false; // Other cases could default to false, depending on your needs
         }
-        throw runtime_error("Not a string value");
     }
 
-    std::shared_ptr<Class> asClass() const;
+    [[nodiscard]] Class *asClass() const;
+
+    [[nodiscard]] Function *asFunction() const;
 
-    std::shared_ptr<Function> asFunction() const;
+    // The object behind an object, function or class value
+    [[nodiscard]] Object *asObject() const;
 
-    std::shared_ptr<Object> asObject() const;
+    void printValue() const;
 
 private:
-    TokenType type;
-    std::shared_ptr<ValueType> value;
+    friend class Heap; // Updates the references of values whose object a minor collection moved
 
-public:
-    [[nodiscard]] shared_ptr<ValueType> getValue() const {
-        return value;
+    explicit Value(TokenType type) : storage_{.regular = {type, 0, {}}} {
+    }
+
+    explicit Value(ValueType *heapValue);
+
+    // A short string made of `first` followed by `second`
+    Value(string_view first, string_view second);
+
+    union Payload {
+        double number;
+        bool boolean;
+        const ValueType *heap;
+        Object *object; // Objects, functions and classes alike
+    };
+
+    // Both representations start with the tag and the form, which either one may read
+    struct Regular {
+        TokenType type;
+        uint8_t form; // 0, except in a short string
+        Payload payload;
+    };
+
+    struct Small {
+        TokenType type;
+        uint8_t form; // The length plus one
+        char characters[SMALL_STRING_CAPACITY];
+    };
+
+    union Storage {
+        Regular regular;
+        Small small;
+    };
+
+    Storage storage_;
+
+    [[nodiscard]] const Payload &payload() const {
+        return storage_.regular.payload;
+    }
+
+    Payload &payload() {
+        return storage_.regular.payload;
+    }
+
+    [[nodiscard]] bool isSmall() const {
+        return storage_.regular.form != 0;
     }
 
+    // Only long strings own a box; everything else is inline or owned by the garbage collector
+    [[nodiscard]] bool isBoxed() const {
+        return isString() && !isSmall();
+    }
+
+    [[nodiscard]] const StringValue *box() const {
+        return static_cast<const StringValue *>(payload().heap);
+    }
+
+    [[nodiscard]] size_t stringLength() const {
+        return isSmall() ? storage_.small.form - 1u : box()->length();
+    }
+
+    // A new reference to a box holding the string, for a rope node to take over
+    [[nodiscard]] const StringValue *shareBox() const;
+
+    [[nodiscard]] bool equalsString(const Value &other) const;
+
+    void swap(Value &other) noexcept {
+        std::swap(storage_, other.storage_);
+    }
+
+public:
     [[nodiscard]] TokenType getType() const {
-        return type;
+        return storage_.regular.type;
+    }
+};
+
+template<>
+struct std::hash<Value> {
+    size_t operator()(const Value &value) const {
+        return value.hash();
     }
 };
 
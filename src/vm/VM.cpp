@@ -0,0 +1,358 @@
+#include "VM.h"
+
+#include <cmath>
+#include <iterator>
+#include <iostream>
+#include <stdexcept>
+
+#include "builtins/array/ArrayClass.h"
+#include "class/Class.h"
+#include "function/Function.h"
+
+using namespace std;
+
+// Labels as values, which threaded dispatch is built on, are a GCC and Clang extension; other
+// compilers always dispatch through the switch
+#if defined(__GNUC__) || defined(__clang__)
+#define YOLO_THREADED_DISPATCH 1
+#else
+#define YOLO_THREADED_DISPATCH 0
+#endif
+
+
+VM::VM(const Dispatch dispatch)
+    : dispatch_(dispatch), heap_(Heap::current()) {
+    stack_.reserve(256);
+    heap_.addRoots(this);
+    registerBuiltIns();
+}
+
+VM::~VM() {
+    heap_.removeRoots(this);
+}
+
+// Every value the running program can reach is on the stack, in a slot or a global, so the
+// safepoints on loop back edges and after each statement can collect at any depth of the stack
+void VM::traceRoots(Heap &heap) {
+    for (Value &value: stack_) {
+        heap.mark(value);
+    }
+    for (Value &value: slots_) {
+        heap.mark(value);
+    }
+    for (auto &[name, value]: globals_) {
+        heap.mark(value);
+    }
+    heap.mark(lastValue_);
+}
+
+void VM::run(const Chunk &chunk) {
+    stack_.clear();
+    slots_.assign(chunk.slotCount, Value());
+    caches_.assign(chunk.cacheCount, InlineCache());
+    try {
+        if (dispatch_ == Dispatch::THREADED) {
+            execute<true>(chunk);
+        } else {
+            execute<false>(chunk);
+        }
+    } catch (const exception &e) {
+        cerr << "Runtime error: " << e.what() << endl;
+    }
+}
+
+template<bool Threaded>
+void VM::execute(const Chunk &chunk) {
+    const uint8_t *const code = chunk.code.data();
+    const uint8_t *ip = code;
+
+    const auto readShort = [&ip] {
+        ip += 2;
+        return static_cast<uint16_t>(ip[-2] << 8 | ip[-1]);
+    };
+
+    // Every handler starts with CASE and ends with NEXT, which either jumps straight to the next
+    // handler or leaves the switch for the loop to dispatch
+#if YOLO_THREADED_DISPATCH
+#define CASE(name) case OpCode::name: [[maybe_unused]] op_##name:
+#define UNKNOWN_CASE default: [[maybe_unused]] op_UNKNOWN:
+#define NEXT() \
+    if constexpr (Threaded) { \
+        goto *handlers[ip++ - code]; \
+    } else { \
+        break; \
+    }
+#else
+#define CASE(name) case OpCode::name:
+#define UNKNOWN_CASE default:
+#define NEXT() break
+#endif
+
+    // Replaces the two operands on top of the stack with the result of `op` on their doubles
+#define BINARY_OP(op) \
+    do { \
+        const double right = stack_.back().asDouble(); \
+        stack_.pop_back(); \
+        stack_.back() = Value(stack_.back().asDouble() op right); \
+    } while (false)
+
+    // The same for the bitwise operators, which work on the operands as 32-bit integers
+#define BITWISE_OP(op) \
+    do { \
+        const int32_t right = stack_.back().asInt32(); \
+        stack_.pop_back(); \
+        stack_.back() = Value(static_cast<double>(stack_.back().asInt32() op right)); \
+    } while (false)
+
+#if YOLO_THREADED_DISPATCH
+    // Direct threading: the program is linked into one handler address per instruction before it
+    // runs, so every dispatch is a single indirect jump to the next instruction's handler. The
+    // switch below still holds the handlers; threaded code just never goes back to its head.
+    vector<const void *> handlers;
+    if constexpr (Threaded) {
+        // In OpCode order
+        static const void *const labels[] = {
+            &&op_CONSTANT, &&op_NIL, &&op_TRUE, &&op_FALSE, &&op_POP,
+            &&op_DEFINE_LOCAL, &&op_GET_LOCAL, &&op_SET_LOCAL, &&op_GET_GLOBAL, &&op_SET_GLOBAL, &&op_GET_PROPERTY,
+            &&op_ADD, &&op_SUBTRACT, &&op_MULTIPLY, &&op_DIVIDE, &&op_MODULO,
+            &&op_EQUAL, &&op_NOT_EQUAL, &&op_STRICT_EQUAL, &&op_STRICT_NOT_EQUAL,
+            &&op_LESS, &&op_LESS_EQUAL, &&op_GREATER, &&op_GREATER_EQUAL,
+            &&op_BITWISE_AND, &&op_BITWISE_OR, &&op_BITWISE_XOR, &&op_LEFT_SHIFT, &&op_RIGHT_SHIFT,
+            &&op_UNSIGNED_RIGHT_SHIFT, &&op_NEGATE, &&op_NOT, &&op_BITWISE_NOT, &&op_TRUTHY,
+            &&op_JUMP, &&op_JUMP_IF_FALSE, &&op_LOOP,
+            &&op_CALL, &&op_PRINT_RESULT, &&op_HALT,
+        };
+        static_assert(size(labels) == static_cast<size_t>(OpCode::HALT) + 1, "Every opcode needs a handler.");
+
+        // Indexed by the offset of each instruction's opcode; operand bytes are never dispatched on
+        handlers.assign(chunk.code.size(), &&op_UNKNOWN);
+        for (size_t offset = 0; offset < chunk.code.size();) {
+            const auto op = static_cast<OpCode>(chunk.code[offset]);
+            if (op > OpCode::HALT) {
+                offset++;
+                continue;
+            }
+            handlers[offset] = labels[static_cast<size_t>(op)];
+            offset += instructionLength(op);
+        }
+        goto *handlers[ip++ - code];
+    }
+#endif
+
+    while (true) {
+        switch (static_cast<OpCode>(*ip++)) {
+            CASE(CONSTANT)
+                stack_.push_back(chunk.constants[readShort()]);
+                NEXT();
+            CASE(NIL)
+                stack_.emplace_back();
+                NEXT();
+            CASE(TRUE)
+                stack_.emplace_back(true);
+                NEXT();
+            CASE(FALSE)
+                stack_.emplace_back(false);
+                NEXT();
+            CASE(POP)
+                lastValue_ = pop();
+                NEXT();
+
+            CASE(DEFINE_LOCAL) {
+                Value &slot = slots_[readShort()];
+                slot = pop();
+                lastValue_ = slot;
+                NEXT();
+            }
+            CASE(GET_LOCAL)
+                stack_.push_back(slots_[readShort()]);
+                NEXT();
+            CASE(SET_LOCAL)
+                slots_[readShort()] = stack_.back();
+                NEXT();
+            CASE(GET_GLOBAL) {
+                const Symbol name = chunk.names[readShort()];
+                const auto it = globals_.find(name);
+                if (it == globals_.end()) {
+                    throw runtime_error("Undefined variable '" + name.str() + "'.");
+                }
+                stack_.push_back(it->second);
+                NEXT();
+            }
+            CASE(SET_GLOBAL) {
+                // Script variables are always locals, so the only globals are the constant builtins
+                const Symbol name = chunk.names[readShort()];
+                if (globals_.contains(name)) {
+                    throw runtime_error("Cannot reassign constant variable '" + name.str() + "'.");
+                }
+                throw runtime_error("Undefined variable '" + name.str() + "'.");
+            }
+            CASE(GET_PROPERTY) {
+                const Symbol name = chunk.names[readShort()];
+                InlineCache &cache = caches_[readShort()];
+                stack_.back() = cache.get(stack_.back(), name);
+                NEXT();
+            }
+
+            CASE(ADD)
+                // Adding two strings concatenates them
+                if (stack_.back().isString() && stack_.end()[-2].isString()) {
+                    const Value right = pop();
+                    stack_.back() = Value::concatenate(stack_.back(), right);
+                } else {
+                    BINARY_OP(+);
+                }
+                NEXT();
+            CASE(SUBTRACT)
+                BINARY_OP(-);
+                NEXT();
+            CASE(MULTIPLY)
+                BINARY_OP(*);
+                NEXT();
+            CASE(DIVIDE) {
+                const double right = stack_.back().asDouble();
+                if (right == 0) {
+                    throw runtime_error("Division by zero");
+                }
+                stack_.pop_back();
+                stack_.back() = Value(stack_.back().asDouble() / right);
+                NEXT();
+            }
+            CASE(MODULO) {
+                const double right = stack_.back().asDouble();
+                stack_.pop_back();
+                stack_.back() = Value(fmod(stack_.back().asDouble(), right));
+                NEXT();
+            }
+            CASE(EQUAL)
+                BINARY_OP(==);
+                NEXT();
+            CASE(NOT_EQUAL)
+                BINARY_OP(!=);
+                NEXT();
+            CASE(STRICT_EQUAL) {
+                const Value right = pop();
+                stack_.back() = Value(stack_.back() == right);
+                NEXT();
+            }
+            CASE(STRICT_NOT_EQUAL) {
+                const Value right = pop();
+                stack_.back() = Value(!(stack_.back() == right));
+                NEXT();
+            }
+            CASE(LESS)
+                BINARY_OP(<);
+                NEXT();
+            CASE(LESS_EQUAL)
+                BINARY_OP(<=);
+                NEXT();
+            CASE(GREATER)
+                BINARY_OP(>);
+                NEXT();
+            CASE(GREATER_EQUAL)
+                BINARY_OP(>=);
+                NEXT();
+            CASE(BITWISE_AND)
+                BITWISE_OP(&);
+                NEXT();
+            CASE(BITWISE_OR)
+                BITWISE_OP(|);
+                NEXT();
+            CASE(BITWISE_XOR)
+                BITWISE_OP(^);
+                NEXT();
+            CASE(LEFT_SHIFT) {
+                const int32_t right = stack_.back().asInt32() & 31;
+                stack_.pop_back();
+                stack_.back() = Value(static_cast<double>(stack_.back().asInt32() << right));
+                NEXT();
+            }
+            CASE(RIGHT_SHIFT) {
+                const int32_t right = stack_.back().asInt32() & 31;
+                stack_.pop_back();
+                stack_.back() = Value(static_cast<double>(stack_.back().asInt32() >> right));
+                NEXT();
+            }
+            CASE(UNSIGNED_RIGHT_SHIFT) {
+                const int32_t right = stack_.back().asInt32() & 31;
+                stack_.pop_back();
+                stack_.back() = Value(static_cast<double>(static_cast<uint32_t>(stack_.back().asInt32()) >> right));
+                NEXT();
+            }
+            CASE(NEGATE)
+                stack_.back() = Value(-stack_.back().asDouble());
+                NEXT();
+            CASE(NOT)
+                stack_.back() = Value(!stack_.back().isTruthy());
+                NEXT();
+            CASE(BITWISE_NOT)
+                stack_.back() = Value(static_cast<double>(~stack_.back().asInt32()));
+                NEXT();
+            CASE(TRUTHY)
+                stack_.back() = Value(stack_.back().isTruthy());
+                NEXT();
+
+            CASE(JUMP) {
+                const uint16_t offset = readShort();
+                ip += offset;
+                NEXT();
+            }
+            CASE(JUMP_IF_FALSE) {
+                const uint16_t offset = readShort();
+                if (!stack_.back().isTruthy()) {
+                    ip += offset;
+                }
+                NEXT();
+            }
+            CASE(LOOP) {
+                const uint16_t offset = readShort();
+                ip -= offset;
+                heap_.safepoint();
+                NEXT();
+            }
+
+            CASE(CALL)
+                callValue(readShort());
+                NEXT();
+            CASE(PRINT_RESULT)
+                cout << "Statement Result: " << endl;
+                lastValue_.printValue();
+                heap_.safepoint();
+                NEXT();
+            CASE(HALT)
+                return;
+            UNKNOWN_CASE
+                throw runtime_error("Unknown opcode");
+        }
+    }
+
+#undef BINARY_OP
+#undef BITWISE_OP
+#undef CASE
+#undef UNKNOWN_CASE
+#undef NEXT
+}
+
+Value VM::pop() {
+    Value value = move(stack_.back());
+    stack_.pop_back();
+    return value;
+}
+
+// Calls the value below the top `argumentCount` stack entries and replaces all of them with the result
+void VM::callValue(const uint16_t argumentCount) {
+    const size_t calleeIndex = stack_.size() - argumentCount - 1;
+    if (!stack_[calleeIndex].isFunction()) {
+        throw runtime_error("Can only call functions.");
+    }
+    const auto function = stack_[calleeIndex].asFunction();
+
+    const vector<Value> arguments(make_move_iterator(stack_.begin() + static_cast<ptrdiff_t>(calleeIndex) + 1),
+                                  make_move_iterator(stack_.end()));
+    Value result = function->call(arguments);
+    stack_.resize(calleeIndex);
+    stack_.push_back(move(result));
+}
+
+void VM::registerBuiltIns() {
+    globals_.emplace(Symbol::intern("Array"), Value(ArrayClass::shared()));
+}
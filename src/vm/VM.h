@@ -0,0 +1,58 @@
+#ifndef VM_H
+#define VM_H
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "compiler/Chunk.h"
+#include "gc/Heap.h"
+#include "value/Value.h"
+#include "object/InlineCache.h"
+#include "../../include/Symbol.h"
+
+// Stack-based virtual machine that executes a Chunk produced by the Compiler.
+// Locals live in a flat slot array indexed by the compiler; only builtins are looked up by name.
+// Registers itself with the calling thread's heap as a source of roots while it exists.
+class VM : public RootSource {
+public:
+    // How the VM gets from one instruction to the next: a switch on each opcode, or threaded code,
+    // where each instruction jumps directly to the next one's handler (the switch where the
+    // compiler cannot do that)
+    enum class Dispatch { SWITCH, THREADED };
+
+    explicit VM(Dispatch dispatch = Dispatch::THREADED);
+
+    ~VM() override;
+
+    VM(const VM &) = delete;
+
+    VM &operator=(const VM &) = delete;
+
+    // Executes a compiled program, reporting runtime errors the same way as the Interpreter
+    void run(const Chunk &chunk);
+
+    void traceRoots(Heap &heap) override;
+
+private:
+    Dispatch dispatch_;
+    Heap &heap_;
+    vector<Value> stack_;
+    vector<Value> slots_;
+    unordered_map<Symbol, Value> globals_;
+    vector<InlineCache> caches_; // One per GET_PROPERTY site
+
+    // Result of the most recently completed expression, printed after each top-level statement
+    Value lastValue_;
+
+    template<bool Threaded>
+    void execute(const Chunk &chunk);
+
+    Value pop();
+
+    void callValue(uint16_t argumentCount);
+
+    void registerBuiltIns();
+};
+
+#endif // VM_H